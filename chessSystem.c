@@ -1,22 +1,19 @@
 #include <stdlib.h>
 #include "chessSystem.h"
 #include "tournament.h"
-#include "matchnode.h"
+#include "matchvector.h"
 #include "player.h"
 #include "match.h"
-#include "utils.h"
+#include "matchtable.h"
 #include "map.h"
 
 struct chess_system_t
 {
   Map tournaments;
   Map players;
-  matchNode matches;
+  MatchVector matches;
 };
 
-static MapKeyElement copyId(MapKeyElement element);
-static void freeId(MapKeyElement element);
-
 /**
  * Validates that the provided location string is in compliance
  * with the location demands:
@@ -60,6 +57,58 @@ static Player getWinner(Player first_player, Player second_player, Winner winner
  */
 static void chessRemoveMatchesByTournament(ChessSystem chess, Tournament tournament);
 
+/**
+ * Prints the statistics of an ended tournament: the winner's id, the longest
+ * and average game time, the location and the numbers of games and players.
+ * 
+ * @param tournament ended Tournament in question
+ * @param file an open, writable output stream
+ * @return
+ *    CHESS_OUT_OF_MEMORY - memory failure occured
+ *    CHESS_SAVE_FAILURE - printing failed
+ *    CHESS_SUCCESS - statistics were printed successfully
+ */
+static ChessResult chessSaveTournament(Tournament tournament, FILE *file);
+
+/**
+ * Parameters of a new tournament, the context of createTournament
+ */
+typedef struct tournament_parameters_t
+{
+  const char *location;
+  int max_games_per_player;
+} TournamentParameters;
+
+/**
+ * Creates the Tournament of a missing tournament ID, for mapTryInsert
+ * 
+ * @param key tournament ID
+ * @param context TournamentParameters of the new tournament
+ * @return
+ *    New Tournament, NULL in case of memory error
+ */
+static MapDataElement createTournament(MapKeyElement key, void *context);
+
+/**
+ * Creates the Player of a missing player ID, for mapGetOrInsert
+ * 
+ * @param key player ID
+ * @param context unused
+ * @return
+ *    New Player, NULL in case of memory error
+ */
+static MapDataElement createPlayer(MapKeyElement key, void *context);
+
+/**
+ * Copy and free functions of the tournaments and players maps, which hand
+ * the elements to the typed functions of their modules. Tournaments are
+ * never copied (see copyTournament).
+ */
+static MapDataElement copyTournament(MapDataElement tournament);
+static void freeTournament(MapDataElement tournament);
+static MapDataElement copyPlayer(MapDataElement player);
+static void freePlayer(MapDataElement player);
+
 ChessSystem chessCreate()
 {
   ChessSystem chess = (ChessSystem)malloc(sizeof(struct chess_system_t));
@@ -68,25 +117,28 @@ ChessSystem chessCreate()
     return NULL;
   }
 
-  chess->tournaments = mapCreate(tournamentCopy, 
-                                 copyId, 
-                                 tournamentDestroy, 
-                                 freeId, 
-                                 tournamentCompare);
+  chess->tournaments = mapCreateIntKeyed(copyTournament, freeTournament);
   if (NULL == chess->tournaments) {
+    free(chess);
     return NULL;
   }
 
-  chess->players = mapCreate(playerCopy, 
-                             copyId, 
-                             playerDestroy, 
-                             freeId, 
-                             playerCompare);
+  chess->players = mapCreateIntKeyed(copyPlayer, freePlayer);
   if (NULL == chess->players) {
+    mapDestroy(chess->tournaments);
+    free(chess);
+    return NULL;
+  }
+
+  chess->matches = matchVectorCreate(MATCH_HOOK_SYSTEM, NULL);
+  if (NULL == chess->matches) {
+    mapDestroy(chess->players);
+    mapDestroy(chess->tournaments);
+    free(chess);
     return NULL;
   }
 
-  chess->matches = NULL;
+  return chess;
 }
 
 #define NOT_NULL(arg)           \
@@ -99,10 +151,10 @@ ChessSystem chessCreate()
     return CHESS_INVALID_ID;  \
   }
 
-#define GET_TOURNAMENT(tournament_id, tournament)         \
-  tournament = mapGet(chess->tournaments, tournament_id); \
-  if (NULL == tournament) {                               \
-    return CHESS_TOURNAMENT_NOT_EXIST;                    \
+#define GET_TOURNAMENT(tournament_id, tournament)          \
+  tournament = mapGet(chess->tournaments, &tournament_id); \
+  if (NULL == tournament) {                                \
+    return CHESS_TOURNAMENT_NOT_EXIST;                     \
   }
 
 #define GET_PLAYER(player_id, player)                         \
@@ -115,16 +167,12 @@ ChessSystem chessCreate()
 
 void chessDestroy(ChessSystem chess)
 {
+  // the vectors which only refer to the matches go first, as they unhook
+  // the matches on the way. matches are destroyed along with their tournaments
   mapDestroy(chess->players);
+  matchVectorDestroy(chess->matches, false);
   mapDestroy(chess->tournaments);
 
-  matchNode head = chess->matches, next;
-  while (NULL != head) {
-    next = nextMatchNode(head);
-    matchNodeDestroy(head, true);
-    head = next;
-  }
-
   free(chess);
 }
 
@@ -143,40 +191,27 @@ ChessResult chessAddTournament(ChessSystem chess,
     return CHESS_INVALID_LOCATION;
   }
 
-  // tournament with that id was already added
-  if (mapContains(chess->tournaments, tournament_id)) {
-    return CHESS_TOURNAMENT_ALREADY_EXISTS;
-  }
+  TournamentParameters parameters = {tournament_location, max_games_per_player};
+  MapDataElement tournament;
 
-  Tournament tournament = tournamentCreate(tournament_id,
-                                           tournament_location,
-                                           max_games_per_player);
-
-  if (NULL == tournament) {
-    return CHESS_OUT_OF_MEMORY;
-  }
-
-  // all parameters are certainly not null so an error must be memory related
-  if (MAP_SUCCESS != mapPut(chess->tournaments, 
-                            (MapKeyElement) &tournament_id, 
-                            (MapDataElement) tournament)) {
+  // the tournament is created only if the id is not taken yet
+  switch (mapTryInsert(chess->tournaments, (MapKeyElement) &tournament_id,
+                       createTournament, &parameters, &tournament)) {
+  case MAP_SUCCESS:
+    return CHESS_SUCCESS;
+  case MAP_ITEM_ALREADY_EXISTS:
+    return CHESS_TOURNAMENT_ALREADY_EXISTS;
+  default:
+    // all parameters are certainly not null so an error must be memory related
     return CHESS_OUT_OF_MEMORY;
   }
-
-  return CHESS_SUCCESS;
 }
 
-#define GET_CREATE_PLAYER(player_id, player)                                        \
-  player = mapGet(chess->players, (MapKeyElement)&player_id);                       \
-  if (NULL == player) {                                                             \
-    player = playerCreate(first_player);                                            \
-    if (NULL == player) {                                                           \
-      return CHESS_OUT_OF_MEMORY;                                                   \
-    }                                                                               \
-    if (MAP_SUCCESS != mapPut(chess->players, (MapKeyElement)&player_id, player)) { \
-      playerDestroy(player, false);                                                 \
-      return CHESS_OUT_OF_MEMORY;                                                   \
-    }                                                                               \
+#define GET_CREATE_PLAYER(player_id, player)                                   \
+  player = mapGetOrInsert(chess->players, (MapKeyElement)&player_id,           \
+                          createPlayer, NULL);                                 \
+  if (NULL == player) {                                                        \
+    return CHESS_OUT_OF_MEMORY;                                                \
   }
 
 ChessResult chessAddGame(ChessSystem chess, int tournament_id, int first_player,
@@ -210,19 +245,17 @@ ChessResult chessAddGame(ChessSystem chess, int tournament_id, int first_player,
     return CHESS_OUT_OF_MEMORY;
   }
 
-  if (tournamentAddMatch(tournament, match) == CHESS_GAME_ALREADY_EXISTS) {
+  ChessResult result = tournamentAddMatch(tournament, match);
+  if (CHESS_SUCCESS != result) {
     matchDestroy(match);
-    return CHESS_GAME_ALREADY_EXISTS;
+    return result;
   }
 
-  matchNode node = newMatchNode(match, chess->matches);
-  if (NULL == node) {  // failed to allocate new node
+  if (CHESS_SUCCESS != matchVectorPush(chess->matches, match)) {
+    tournamentRemoveMatch(tournament, match);
     matchDestroy(match);
-
     return CHESS_OUT_OF_MEMORY;
   }
-
-  chess->matches = node;
   
   if (CHESS_OUT_OF_MEMORY == playerAddMatch(player1, match) ||
       CHESS_OUT_OF_MEMORY == playerAddMatch(player2, match)) {
@@ -238,12 +271,14 @@ ChessResult chessRemoveTournament(ChessSystem chess, int tournament_id)
   NOT_NULL(chess)
   VALIDATE_ID(tournament_id)
 
-  Tournament tournament;
-  GET_TOURNAMENT(tournament_id, tournament)
+  // tournament is taken out of the map, so it is destroyed only once
+  Tournament tournament = mapTake(chess->tournaments, (MapKeyElement) &tournament_id);
+  if (NULL == tournament) {
+    return CHESS_TOURNAMENT_NOT_EXIST;
+  }
 
   chessRemoveMatchesByTournament(chess, tournament);
   tournamentDestroy(tournament);
-  mapRemove(chess->tournaments, (MapKeyElement) &tournament_id);
   return CHESS_SUCCESS;
 }
 
@@ -252,11 +287,19 @@ ChessResult chessRemovePlayer(ChessSystem chess, int player_id)
   NOT_NULL(chess)
   VALIDATE_ID(player_id)
 
-  Player player;
-  GET_PLAYER(player_id, player)
+  // player is taken out of the map, so it is destroyed only once
+  Player player = mapTake(chess->players, (MapKeyElement) &player_id);
+  if (NULL == player) {
+    return CHESS_PLAYER_NOT_EXIST;
+  }
 
+  // running tournaments forfeit his games, ended ones keep their results
+  MAP_ITERATE(iterator, chess->tournaments) {
+    tournamentRemovePlayer(mapIteratorData(&iterator), player_id);
+  }
+
+  // his games stay in their tournaments, without pointing at him
   playerDestroy(player, true);
-  mapRemove(chess->players, (MapKeyElement) &player_id);
   return CHESS_SUCCESS;
 }
 
@@ -293,7 +336,71 @@ double chessCalculateAveragePlayTime (ChessSystem chess, int player_id, ChessRes
     return 0.0;                            
   }
 
+  // the player keeps the total play time, so no game is visited
+  *chess_result = CHESS_SUCCESS;
+  return playerGetAveragePlayTime(player);
+}
+
+ChessResult chessSaveTournamentStatistics (ChessSystem chess, char* path_file)
+{
+  NOT_NULL(chess)
 
+  bool ended = false;
+  MAP_ITERATE(iterator, chess->tournaments) {
+    if (tournamentIsEnded(mapIteratorData(&iterator))) {
+      ended = true;
+      break;
+    }
+  }
+  if (!ended) {
+    return CHESS_NO_TOURNAMENTS_ENDED;
+  }
+
+  if (NULL == path_file) {
+    return CHESS_SAVE_FAILURE;
+  }
+  FILE *file = fopen(path_file, "w");
+  if (NULL == file) {
+    return CHESS_SAVE_FAILURE;
+  }
+
+  // tournaments are printed by increasing id, the order of the map
+  ChessResult result = CHESS_SUCCESS;
+  MAP_ITERATE(iterator, chess->tournaments) {
+    Tournament tournament = mapIteratorData(&iterator);
+    if (tournamentIsEnded(tournament)) {
+      result = chessSaveTournament(tournament, file);
+      if (CHESS_SUCCESS != result) {
+        break;
+      }
+    }
+  }
+
+  if ((EOF == fclose(file)) && (CHESS_SUCCESS == result)) {
+    result = CHESS_SAVE_FAILURE;
+  }
+  return result;
+}
+
+static ChessResult chessSaveTournament(Tournament tournament, FILE *file)
+{
+  // the game times are aggregated over a columnar table of the tournament's
+  // own games, which its vector already holds apart from all the others
+  MatchTable table = matchTableCreate(tournamentGetMatches(tournament));
+  if (NULL == table) {
+    return CHESS_OUT_OF_MEMORY;
+  }
+
+  int printed = fprintf(file, "%d\n%d\n%.2f\n%s\n%d\n%d\n",
+                        tournamentGetWinnerId(tournament),
+                        matchTableLongestDuration(table),
+                        matchTableAverageDuration(table),
+                        tournamentGetLocation(tournament),
+                        matchTableGetSize(table),
+                        tournamentGetPlayersCount(tournament));
+  matchTableDestroy(table);
+
+  return (printed < 0) ? CHESS_SAVE_FAILURE : CHESS_SUCCESS;
 }
 
 static Player getWinner(Player first_player, Player second_player, Winner winner)
@@ -303,6 +410,87 @@ static Player getWinner(Player first_player, Player second_player, Winner winner
     return first_player;
   case SECOND_PLAYER:
     return second_player;
+  case DRAW:
+    break;
   }
   return NULL;
+}
+
+static bool validateLocation(const char *location)
+{
+  if (('\0' == *location) || (*location < 'A') || (*location > 'Z')) {
+    return false;
+  }
+
+  for (const char *letter = location + 1; '\0' != *letter; letter++) {
+    if ((' ' != *letter) && ((*letter < 'a') || (*letter > 'z'))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static inline bool validateId(int id)
+{
+  return id > 0;
+}
+
+static MapDataElement createTournament(MapKeyElement key, void *context)
+{
+  TournamentParameters *parameters = (TournamentParameters *)context;
+
+  return tournamentCreate(*(int *)key, parameters->location,
+                          parameters->max_games_per_player);
+}
+
+static MapDataElement createPlayer(MapKeyElement key, void *context)
+{
+  (void)context;
+
+  return playerCreate(*(int *)key);
+}
+
+static MapDataElement copyTournament(MapDataElement tournament)
+{
+  // tournaments are created in the map by mapTryInsert and never copied. a
+  // tournament owns the arena of its matches, which are also held by the
+  // players, so a copy could not be made without copying the whole system
+  (void)tournament;
+  return NULL;
+}
+
+static void freeTournament(MapDataElement tournament)
+{
+  tournamentDestroy((Tournament)tournament);
+}
+
+static MapDataElement copyPlayer(MapDataElement player)
+{
+  return playerCopy((Player)player);
+}
+
+static void freePlayer(MapDataElement player)
+{
+  // the matches of the player are destroyed along with their tournaments
+  playerDestroy((Player)player, false);
+}
+
+static void chessRemoveMatchesByTournament(ChessSystem chess, Tournament tournament)
+{
+  MatchVector matches = tournamentGetMatches(tournament);
+  Match *data = matchVectorData(matches);
+
+  // every match knows its position in each vector, so each removal is O(1)
+  for (int i = 0; i < matchVectorGetSize(matches); i++) {
+    matchVectorRemove(chess->matches, data[i]);
+
+    // a removed player no longer holds the match, and is not touched
+    Player participants[] = {matchGetFirst(data[i]), matchGetSecond(data[i])};
+    for (int j = 0; j < 2; j++) {
+      if (*matchGetHook(data[i], MATCH_HOOK_PLAYER, participants[j]) >= 0) {
+        playerRemoveMatch(participants[j], data[i]);
+      }
+    }
+  }
 }
\ No newline at end of file
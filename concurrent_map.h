@@ -0,0 +1,234 @@
+#ifndef CONCURRENT_MAP_H_
+#define CONCURRENT_MAP_H_
+
+#include <stdbool.h>
+#include "map.h"
+
+/**
+* Concurrent Map Container
+*
+* A map with the semantics of map.h which may be used from several threads
+* at once. Its keys are split between a number of shards by a hash of the
+* key, and every shard is a Map guarded by its own reader-writer lock, so
+* threads working on different shards never wait for each other and readers
+* of the same shard proceed together.
+*
+* The concurrent map has no internal iterator. Iteration state lives on the
+* stack of the iterating thread, so any number of threads may iterate at once.
+* The order of iteration is by shard, and ordered by key within every shard.
+*
+* The following functions are available:
+*   concurrentMapCreate		- Creates a new empty concurrent map
+*   concurrentMapCreateIntKeyed	- Creates a new empty concurrent map keyed by int
+*   concurrentMapDestroy	- Deletes an existing map and frees all resources
+*   concurrentMapGetSize	- Returns the size of a given map
+*   concurrentMapContains	- Returns weather or not a key exists inside the map
+*   concurrentMapPut		- Gives a specific key a given value
+*   concurrentMapPutOwned	- Gives a specific key a given value, which the map
+*   				  adopts instead of copying
+*   concurrentMapGet		- Returns a copy of the data paired to a key
+*   concurrentMapRemove	- Removes a pair of (key,data) elements
+*   concurrentMapTake		- Removes a pair of (key,data) elements and hands
+*   				  the data element back to the caller
+*   concurrentMapForEach	- Calls a function on every pair of the map
+*   concurrentMapClear		- Clears the contents of the map
+*/
+
+/** Type for defining the concurrent map */
+typedef struct ConcurrentMap_t *ConcurrentMap;
+
+/** Type of function for hashing a key element, used to pick its shard */
+typedef unsigned int(*hashMapKeyElement)(MapKeyElement);
+
+/**
+* Type of function called on every pair of the map by concurrentMapForEach.
+* Gets the key, the data and the context given to concurrentMapForEach, and
+* returns false to stop the iteration.
+*/
+typedef bool(*concurrentMapAction)(MapKeyElement, MapDataElement, void *);
+
+/**
+* concurrentMapCreate: Allocates a new empty concurrent map.
+*
+* @param shards - Number of shards to split the map between. Should be about
+* 		the number of threads expected to use the map at once.
+* @param copyDataElement - Function pointer to be used for copying data elements
+* 		into the map or when copying the map.
+* @param copyKeyElement - Function pointer to be used for copying key elements
+* 		into the map or when copying the map.
+* @param freeDataElement - Function pointer to be used for removing data elements
+* 		from the map
+* @param freeKeyElement - Function pointer to be used for removing key elements
+* 		from the map
+* @param compareKeyElements - Function pointer to be used for comparing key
+* 		elements inside the map.
+* @param hashKeyElement - Function pointer to be used for picking the shard of
+* 		a key. Keys which are equal by compareKeyElements must have equal hashes.
+* @return
+* 	NULL - if one of the parameters is NULL, shards is not positive or
+* 	allocations failed.
+* 	A new concurrent map in case of success.
+*/
+ConcurrentMap concurrentMapCreate(int shards,
+                                  copyMapDataElements copyDataElement,
+                                  copyMapKeyElements copyKeyElement,
+                                  freeMapDataElements freeDataElement,
+                                  freeMapKeyElements freeKeyElement,
+                                  compareMapKeyElements compareKeyElements,
+                                  hashMapKeyElement hashKeyElement);
+
+/**
+* concurrentMapCreateIntKeyed: Allocates a new empty concurrent map whose keys
+* are pointers to int, with every shard created by mapCreateIntKeyed.
+*
+* @param shards - Number of shards to split the map between
+* @param copyDataElement - Function pointer to be used for copying data elements
+* 		into the map
+* @param freeDataElement - Function pointer to be used for removing data elements
+* 		from the map
+* @return
+* 	NULL - if one of the parameters is NULL, shards is not positive or
+* 	allocations failed.
+* 	A new concurrent map in case of success.
+*/
+ConcurrentMap concurrentMapCreateIntKeyed(int shards,
+                                          copyMapDataElements copyDataElement,
+                                          freeMapDataElements freeDataElement);
+
+/**
+* concurrentMapDestroy: Deallocates an existing map. Clears all elements by
+* using the stored free functions. Must not be called while other threads
+* still use the map.
+*
+* @param map - Target map to be deallocated. If map is NULL nothing will be
+* 		done
+*/
+void concurrentMapDestroy(ConcurrentMap map);
+
+/**
+* concurrentMapGetSize: Returns the number of elements in a map. When other
+* threads change the map at the same time, the result counts every shard
+* as it was when that shard was visited.
+*
+* @param map - The map which size is requested
+* @return
+* 	-1 if a NULL pointer was sent.
+* 	Otherwise the number of elements in the map.
+*/
+int concurrentMapGetSize(ConcurrentMap map);
+
+/**
+* concurrentMapContains: Checks if a key element exists in the map.
+*
+* @param map - The map to search in
+* @param element - The element to look for. Will be compared using the
+* 		comparison function.
+* @return
+* 	false - if one or more of the inputs is null, or if the key element was not
+* 	found.
+* 	true - if the key element was found in the map.
+*/
+bool concurrentMapContains(ConcurrentMap map, MapKeyElement element);
+
+/**
+* concurrentMapPut: Gives a specified key a specific value, as mapPut.
+*
+* @param map - The map for which to reassign the data element
+* @param keyElement - The key element which need to be reassigned
+* @param dataElement - The new data element to associate with the given key.
+* 		A copy of the element will be inserted as supplied by the copying
+* 		function which is given at initialization.
+* @return
+* 	MAP_NULL_ARGUMENT if a NULL was sent as map or keyElement or dataElement
+* 	MAP_OUT_OF_MEMORY if an allocation failed (Meaning the function for copying
+* 	an element failed)
+* 	MAP_SUCCESS the paired elements had been inserted successfully
+*/
+MapResult concurrentMapPut(ConcurrentMap map,
+                           MapKeyElement keyElement,
+                           MapDataElement dataElement);
+
+/**
+* concurrentMapPutOwned: Gives a specified key a specific value, as
+* mapPutOwned. The map adopts dataElement only if MAP_SUCCESS is returned.
+*
+* @param map - The map for which to reassign the data element
+* @param keyElement - The key element which need to be reassigned
+* @param dataElement - The new data element to associate with the given key.
+* @return
+* 	MAP_NULL_ARGUMENT if a NULL was sent as map or keyElement or dataElement
+* 	MAP_OUT_OF_MEMORY if an allocation failed
+* 	MAP_SUCCESS the paired elements had been inserted successfully
+*/
+MapResult concurrentMapPutOwned(ConcurrentMap map,
+                                MapKeyElement keyElement,
+                                MapDataElement dataElement);
+
+/**
+* concurrentMapGet: Returns a copy of the data associated with a specific key
+* in the map. Unlike mapGet, the data is copied while its shard is locked,
+* since another thread may remove the original right after the call returns.
+*
+* @param map - The map for which to get the data element from.
+* @param keyElement - The key element which need to be found and whose data
+* 		we want to get.
+* @return
+* 	NULL if a NULL pointer was sent, the key was not found or the copy failed.
+* 	Otherwise a copy of the data element, to be freed by the caller.
+*/
+MapDataElement concurrentMapGet(ConcurrentMap map, MapKeyElement keyElement);
+
+/**
+* concurrentMapRemove: Removes a pair of key and data elements from the map,
+* as mapRemove.
+*
+* @param map - The map to remove the elements from.
+* @param keyElement - The key element to find and remove from the map.
+* @return
+* 	MAP_NULL_ARGUMENT if a NULL was sent to the function
+* 	MAP_ITEM_DOES_NOT_EXIST if an equal key item does not already exists in
+* 	the map
+* 	MAP_SUCCESS the paired elements had been removed successfully
+*/
+MapResult concurrentMapRemove(ConcurrentMap map, MapKeyElement keyElement);
+
+/**
+* concurrentMapTake: Removes a pair of key and data elements from the map and
+* hands the data element back to the caller, as mapTake.
+*
+* @param map - The map to remove the elements from.
+* @param keyElement - The key element to find and remove from the map.
+* @return
+* 	NULL if a NULL was sent to the function or the key was not found.
+* 	Otherwise the data element, now owned by the caller.
+*/
+MapDataElement concurrentMapTake(ConcurrentMap map, MapKeyElement keyElement);
+
+/**
+* concurrentMapForEach: Calls action on every pair of key and data elements
+* of the map, until it returns false. Every shard is read locked while its
+* pairs are visited, so action must not change the map.
+*
+* @param map - The map to iterate over
+* @param action - Function to call on every pair
+* @param context - Passed on to action as is
+* @return
+* 	MAP_NULL_ARGUMENT if a NULL was sent as map or action
+* 	MAP_SUCCESS otherwise
+*/
+MapResult concurrentMapForEach(ConcurrentMap map,
+                               concurrentMapAction action,
+                               void *context);
+
+/**
+* concurrentMapClear: Removes all key and data elements from the target map.
+* The elements are deallocated using the stored free functions.
+*
+* @param map - Target map to remove all element from.
+* @return
+* 	MAP_NULL_ARGUMENT - if a NULL pointer was sent.
+* 	MAP_SUCCESS - Otherwise.
+*/
+MapResult concurrentMapClear(ConcurrentMap map);
+
+#endif /* CONCURRENT_MAP_H_ */
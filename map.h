@@ -2,17 +2,25 @@
 #define MAP_H_
 
 #include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
 
 /**
 * Generic Map Container
 *
 * Implements a map container type.
+* The map is kept ordered by its keys in a B-tree, so mapContains, mapPut,
+* mapGet and mapRemove take O(log n) comparisons.
 * The map has an internal iterator for external use. For all functions
 * where the state of the iterator after calling that function is not stated,
 * it is undefined. That is you cannot assume anything about it.
 *
 * The following functions are available:
 *   mapCreate		- Creates a new empty map
+*   mapCreateIntKeyed	- Creates a new empty map keyed by int, with a hash
+*   				  index for constant time mapGet and mapContains
+*   mapCreatePersistent - Creates a new empty map whose copies share its
+*   				  elements until either one changes
 *   mapDestroy		- Deletes an existing map and frees all resources
 *   mapCopy		- Copies an existing map
 *   mapGetSize		- Returns the size of a given map
@@ -21,18 +29,53 @@
 *   mapPut		    - Gives a specific key a given value.
 *   				  If the key exists, the value is overridden.
 *   				  This resets the internal iterator.
+*   mapPutBatch	- Puts sorted arrays of keys and values, in linear time
+*   				  if the map is empty.
+*   				  This resets the internal iterator.
+*   mapMerge		- Puts all the pairs of another map, in linear time
+*   mapUnion		- Creates a map of the pairs of two maps, in linear time
+*   mapPutOwned	- Gives a specific key a given value, which the map adopts
+*   				  instead of copying.
+*   				  This resets the internal iterator.
+*   mapTryInsert	- Inserts a data element made by a given function, only if
+*   				  the key is missing, in a single lookup
+*   mapGetOrInsert	- Returns the data paired to a key, inserting a data
+*   				  element made by a given function if it is missing
 *   mapGet  	    - Returns the data paired to a key which matches the given key.
 *					  Iterator status unchanged
 *   mapRemove		- Removes a pair of (key,data) elements for which the key
 *                    matches a given element (by the key compare function).
 *   				  This resets the internal iterator.
+*   mapRemoveIf	- Removes all the pairs matching a condition, in a
+*   				  single pass
+*   mapTake		- Removes a pair of (key,data) elements and hands the data
+*   				  element back to the caller instead of freeing it.
+*   				  This resets the internal iterator.
 *   mapGetFirst	- Sets the internal iterator to the first (smallest) key in the
 *   				  map, and returns it.
 *   mapGetNext		- Advances the internal iterator to the next key and
 *   				  returns it.
 *	 mapClear		- Clears the contents of the map. Frees all the elements of
 *	 				  the map using the free function.
+*   mapGetStats	- Returns counters of the work done by the map, when built
+*   				  with MAP_STATS defined
+*   mapResetStats	- Zeroes the counters of the map
+*   mapSerialize	- Writes the map to a binary stream
+*   mapDeserialize	- Reads a map written by mapSerialize, in linear time
 * 	 MAP_FOREACH	- A macro for iterating over the map's elements.
+*
+* External iterators do not allocate and do not copy keys, and any number of
+* them may walk the same map at once (e.g. in nested loops):
+*   mapIteratorBegin	- Returns an iterator positioned at the smallest key
+*   mapLowerBound	- Returns an iterator positioned at the smallest key
+*   				  which is not smaller than a given key
+*   mapGetRange	- Returns an iterator over the keys in a closed range
+*   mapIteratorValid	- Returns whether the iterator points to an element
+*   mapIteratorKey	- Returns the current key, owned by the map
+*   mapIteratorData	- Returns the current data element, owned by the map
+*   mapIteratorNext	- Advances the iterator to the next key
+*   MAP_ITERATE		- A macro for iterating over the map with an iterator
+* Any change to the map invalidates all of its external iterators.
 */
 
 /** Type for defining the map */
@@ -76,6 +119,46 @@ typedef void(*freeMapKeyElements)(MapKeyElement);
 */
 typedef int(*compareMapKeyElements)(MapKeyElement, MapKeyElement);
 
+/**
+* Type of function making the data element of a missing key, for
+* mapTryInsert and mapGetOrInsert. It is given the key and the context passed
+* by the caller, and returns a new data element which the map adopts, or NULL
+* if an allocation failed.
+*/
+typedef MapDataElement(*createMapDataElement)(MapKeyElement, void *);
+
+/**
+* Type of function merging the data elements of a key found in both maps given
+* to mapMerge or mapUnion. It is given the key and the data elements of the
+* first and second map, and returns a new data element which the map adopts,
+* or NULL if an allocation failed.
+*/
+typedef MapDataElement(*mergeMapDataElements)(MapKeyElement, MapDataElement,
+                                              MapDataElement);
+
+/**
+* Type of function selecting the pairs removed by mapRemoveIf. It is given
+* the key, the data element and the context passed by the caller, and returns
+* true if the pair should be removed. It must not change the map.
+*/
+typedef bool(*matchMapElements)(MapKeyElement, MapDataElement, void *);
+
+/** Maximal depth of the map's tree, bounds the size of an iterator */
+#define MAP_ITERATOR_MAX_DEPTH 24
+
+/**
+* Type for iterating over a map without allocations. Meant to be declared on
+* the stack, its fields are private to the map.
+*/
+typedef struct MapIterator_t {
+    struct MapNode_t *path[MAP_ITERATOR_MAX_DEPTH];
+    int path_index[MAP_ITERATOR_MAX_DEPTH];
+    int depth;
+    MapKeyElement end;  // last key of a range, NULL if unbounded
+    compareMapKeyElements compare;
+    struct Map_t *map;
+} MapIterator;
+
 /**
 * mapCreate: Allocates a new empty map.
 *
@@ -99,6 +182,55 @@ Map mapCreate(copyMapDataElements copyDataElement,
               freeMapKeyElements freeKeyElement,
               compareMapKeyElements compareKeyElements);
 
+/**
+* mapCreateIntKeyed: Allocates a new empty map whose keys are ints.
+* Keys are passed to and returned from the map functions as int pointers, and
+* are copied, freed and compared by the map itself.
+* A small map is a single sorted array searched by binary search. Once it
+* outgrows that, the map also keeps a hash index of its keys, so mapGet and
+* mapContains take constant time on average. Iteration with mapGetFirst and
+* mapGetNext is still in ascending key order.
+*
+* @param copyDataElement - Function pointer to be used for copying data elements into
+*  	the map or when copying the map.
+* @param freeDataElement - Function pointer to be used for removing data elements from
+* 		the map
+* @return
+* 	NULL - if one of the parameters is NULL or allocations failed.
+* 	A new Map in case of success.
+*/
+Map mapCreateIntKeyed(copyMapDataElements copyDataElement,
+                      freeMapDataElements freeDataElement);
+
+/**
+* mapCreatePersistent: Allocates a new empty persistent map.
+* mapCopy of a persistent map takes O(1): the copy shares the tree of the
+* original map. When either map changes later, only the nodes on the path to
+* the changed key are copied (with their elements, using the copy functions),
+* so a copy serves as a cheap immutable snapshot of the map.
+* Since the data elements returned by mapGet may be shared with copies of the
+* map, they must not be modified in place - put a new value instead.
+*
+* @param copyDataElement - Function pointer to be used for copying data elements into
+*  	the map or when copying the map.
+* @param copyKeyElement - Function pointer to be used for copying key elements into
+*  	the map or when copying the map.
+* @param freeDataElement - Function pointer to be used for removing data elements from
+* 		the map
+* @param freeKeyElement - Function pointer to be used for removing key elements from
+* 		the map
+* @param compareKeyElements - Function pointer to be used for comparing key elements
+* 		inside the map. Used to check if new elements already exist in the map.
+* @return
+* 	NULL - if one of the parameters is NULL or allocations failed.
+* 	A new Map in case of success.
+*/
+Map mapCreatePersistent(copyMapDataElements copyDataElement,
+                        copyMapKeyElements copyKeyElement,
+                        freeMapDataElements freeDataElement,
+                        freeMapKeyElements freeKeyElement,
+                        compareMapKeyElements compareKeyElements);
+
 /**
 * mapDestroy: Deallocates an existing map. Clears all elements by using the
 * stored free functions.
@@ -109,7 +241,8 @@ Map mapCreate(copyMapDataElements copyDataElement,
 void mapDestroy(Map map);
 
 /**
-* mapCopy: Creates a copy of target map.
+* mapCopy: Creates a copy of target map, in linear time (constant time for
+* a persistent map).
 * Iterator values for both maps is undefined after this operation.
 *
 * @param map - Target map.
@@ -160,6 +293,134 @@ bool mapContains(Map map, MapKeyElement element);
 */
 MapResult mapPut(Map map, MapKeyElement keyElement, MapDataElement dataElement);
 
+/**
+*	mapPutBatch: Gives several keys specific values at once. The keys must be
+*  sorted in strictly ascending order (by the key compare function).
+*  If the map is empty the elements are loaded in O(n), otherwise they are put
+*  one by one as in mapPut. Keys and data elements are copied as in mapPut.
+*  Iterator's value is undefined after this operation.
+*
+* @param map - The map to put the elements in
+* @param keyElements - Array of count sorted key elements
+* @param dataElements - Array of count data elements, dataElements[i] is
+*      associated with keyElements[i]
+* @param count - number of elements in the arrays
+* @return
+* 	MAP_NULL_ARGUMENT if a NULL was sent as map or array, or one of the
+* 	elements is NULL. Nothing is put in this case.
+* 	MAP_ERROR if count is negative or the keys are not strictly ascending.
+* 	Nothing is put in this case.
+* 	MAP_OUT_OF_MEMORY if an allocation failed
+* 	MAP_SUCCESS the paired elements had been inserted successfully
+*/
+MapResult mapPutBatch(Map map,
+                      MapKeyElement *keyElements,
+                      MapDataElement *dataElements,
+                      int count);
+
+/**
+*	mapMerge: Puts all the pairs of another map in the map. Both maps are walked
+*  once in key order and the map is rebuilt from the result, so merging takes
+*  O(n + m) instead of a mapPut per key. Both maps must hold the same types of
+*  elements and order their keys alike. Keys and data elements of other are
+*  copied as in mapPut, other is unchanged.
+*  Iterator's value is undefined after this operation.
+*
+* @param map - The map to merge into
+* @param other - The map whose pairs are put in map
+* @param mergeDataElements - Makes the data element of a key found in both
+*      maps, replacing the one in map. If NULL, a copy of the data element of
+*      other replaces it.
+* @return
+* 	MAP_NULL_ARGUMENT if a NULL was sent as map or other
+* 	MAP_OUT_OF_MEMORY if an allocation failed, map is unchanged in this case
+* 	MAP_SUCCESS the pairs had been merged successfully
+*/
+MapResult mapMerge(Map map, Map other, mergeMapDataElements mergeDataElements);
+
+/**
+*	mapUnion: Creates a new map holding the pairs of two maps, merged as in
+*  mapMerge, in O(n + m). The new map has the functions and kind of the first
+*  map, and both maps are unchanged.
+*
+* @param map - The first map
+* @param other - The second map
+* @param mergeDataElements - Makes the data element of a key found in both
+*      maps, from the data elements of map and other. If NULL, a copy of the
+*      data element of other is used.
+* @return
+* 	NULL if a NULL was sent as map or other, or if an allocation failed.
+* 	A new map otherwise.
+*/
+Map mapUnion(Map map, Map other, mergeMapDataElements mergeDataElements);
+
+/**
+*	mapPutOwned: Gives a specified key a specific value, without copying the value.
+*  The map takes ownership of the data element and will free it using the free
+*  function given at initialization. The key is copied as in mapPut.
+*  Iterator's value is undefined after this operation.
+*
+* @param map - The map for which to reassign the data element
+* @param keyElement - The key element which need to be reassigned
+* @param dataElement - The new data element to associate with the given key.
+*      On success the map owns it, and old data memory would be deleted using
+*      the free function given at initialization. On failure the caller
+*      still owns it.
+* @return
+* 	MAP_NULL_ARGUMENT if a NULL was sent as map or keyElement or dataElement
+* 	MAP_OUT_OF_MEMORY if an allocation failed
+* 	MAP_SUCCESS the paired elements had been inserted successfully
+*/
+MapResult mapPutOwned(Map map, MapKeyElement keyElement, MapDataElement dataElement);
+
+/**
+*	mapTryInsert: Inserts a key paired with a new data element, only if the key
+*  is not in the map yet. The map is searched once: the data element is made
+*  by createDataElement only when the key is missing, and adopted by the map
+*  without copying. The key is copied as in mapPut.
+*  Iterator's value is undefined after this operation.
+*
+* @param map - The map to insert to
+* @param keyElement - The key element to find or insert
+* @param createDataElement - Makes the data element of a missing key
+* @param context - Passed to createDataElement as is, may be NULL
+* @param dataElement - OUT the data element paired with the key, owned by the
+*      map. Set on MAP_SUCCESS and MAP_ITEM_ALREADY_EXISTS.
+* @return
+* 	MAP_NULL_ARGUMENT if a NULL was sent as map, keyElement,
+* 	createDataElement or dataElement
+* 	MAP_OUT_OF_MEMORY if an allocation failed or createDataElement returned
+* 	NULL, the key is not inserted in this case
+* 	MAP_ITEM_ALREADY_EXISTS if the key was already in the map, the map is
+* 	unchanged
+* 	MAP_SUCCESS the key had been inserted with a new data element
+*/
+MapResult mapTryInsert(Map map,
+                       MapKeyElement keyElement,
+                       createMapDataElement createDataElement,
+                       void *context,
+                       MapDataElement *dataElement);
+
+/**
+*	mapGetOrInsert: Returns the data element paired with a key, inserting the
+*  key with a data element made by createDataElement if it is missing, as
+*  mapTryInsert.
+*  Iterator's value is undefined after this operation.
+*
+* @param map - The map to search and insert to
+* @param keyElement - The key element to find or insert
+* @param createDataElement - Makes the data element of a missing key
+* @param context - Passed to createDataElement as is, may be NULL
+* @return
+* 	NULL if a NULL was sent as map, keyElement or createDataElement, or if an
+* 	allocation failed.
+* 	The data element paired with the key otherwise, owned by the map.
+*/
+MapDataElement mapGetOrInsert(Map map,
+                              MapKeyElement keyElement,
+                              createMapDataElement createDataElement,
+                              void *context);
+
 /**
 *	mapGet: Returns the data associated with a specific key in the map.
 *			Iterator status unchanged
@@ -189,10 +450,46 @@ MapDataElement mapGet(Map map, MapKeyElement keyElement);
 * @return
 * 	MAP_NULL_ARGUMENT if a NULL was sent to the function
 *  MAP_ITEM_DOES_NOT_EXIST if an equal key item does not already exists in the map
+*  MAP_OUT_OF_MEMORY if the map is persistent and copying a node failed
 * 	MAP_SUCCESS the paired elements had been removed successfully
 */
 MapResult mapRemove(Map map, MapKeyElement keyElement);
 
+/**
+* 	mapRemoveIf: Removes every pair of key and data elements for which condition
+*  returns true, and deallocates them using the free functions supplied at
+*  initialization. The map is walked once and rebuilt from the remaining
+*  pairs, so the whole removal takes O(n) instead of a mapRemove per pair.
+*  Iterator's value is undefined after this operation.
+*
+* @param map - The map to remove the elements from.
+* @param condition - Called once for every pair, in key order
+* @param context - Passed to condition as is, may be NULL
+* @return
+* 	MAP_NULL_ARGUMENT if a NULL was sent as map or condition
+* 	MAP_OUT_OF_MEMORY if an allocation failed, nothing is removed in this case
+* 	MAP_SUCCESS the matching pairs had been removed successfully
+*/
+MapResult mapRemoveIf(Map map, matchMapElements condition, void *context);
+
+/**
+* 	mapTake: Removes a pair of key and data elements from the map and returns the
+*  data element instead of freeing it. The key element is freed using the free
+*  function supplied at initialization.
+*  Iterator's value is undefined after this operation.
+*
+* @param map -
+* 	The map to take the elements from.
+* @param keyElement
+* 	The key element to find and remove from the map.
+* @return
+* 	NULL if a NULL was sent to the function or an equal key item does not
+* 	exist in the map (or the map is persistent and copying a node failed).
+* 	The data element associated with the key otherwise. The caller is
+* 	responsible for freeing it.
+*/
+MapDataElement mapTake(Map map, MapKeyElement keyElement);
+
 /**
 *	mapGetFirst: Sets the internal iterator (also called current key element) to
 *	the smallest key element in the map and returns a copy of it. There doesn't
@@ -221,6 +518,90 @@ MapKeyElement mapGetFirst(Map map);
 MapKeyElement mapGetNext(Map map);
 
 
+/**
+* mapIteratorBegin: Returns an iterator positioned at the smallest key of the map.
+* The internal iterator of the map is not affected.
+*
+* @param map - The map to iterate over
+* @return
+* 	An invalid iterator if a NULL pointer was sent or the map is empty.
+* 	An iterator pointing to the first element of the map otherwise.
+*/
+MapIterator mapIteratorBegin(Map map);
+
+/**
+* mapLowerBound: Returns an iterator positioned at the smallest key of the map
+* which is not smaller than the given key, in O(log n). Iterating from there
+* goes on to the end of the map.
+*
+* @param map - The map to iterate over
+* @param keyElement - The key to start from. Needs not be in the map.
+* @return
+* 	An invalid iterator if a NULL pointer was sent or all keys of the map
+* 	are smaller than keyElement.
+* 	An iterator pointing to the first key not smaller than keyElement otherwise.
+*/
+MapIterator mapLowerBound(Map map, MapKeyElement keyElement);
+
+/**
+* mapGetRange: Returns an iterator over the keys of the map in the closed range
+* [lowKeyElement, highKeyElement]. The iterator becomes invalid once it passes
+* highKeyElement, so iterating over k keys of the range takes O(log n + k).
+* highKeyElement is not copied, and must stay valid while the iterator is used.
+*
+* @param map - The map to iterate over
+* @param lowKeyElement - The smallest key of the range
+* @param highKeyElement - The greatest key of the range
+* @return
+* 	An invalid iterator if a NULL pointer was sent or no key of the map is
+* 	in the range.
+* 	An iterator pointing to the first key of the range otherwise.
+*/
+MapIterator mapGetRange(Map map,
+                        MapKeyElement lowKeyElement,
+                        MapKeyElement highKeyElement);
+
+/**
+* mapIteratorValid: Checks if the iterator points to an element of the map.
+*
+* @param iterator - The iterator in question
+* @return
+* 	false if a NULL pointer was sent or the iterator passed the last element.
+* 	true otherwise.
+*/
+bool mapIteratorValid(const MapIterator *iterator);
+
+/**
+* mapIteratorKey: Returns the key the iterator points to. The key is not copied
+* and still belongs to the map, it must not be freed or modified.
+*
+* @param iterator - The iterator in question
+* @return
+* 	NULL if a NULL pointer was sent or the iterator is not valid.
+* 	The current key element otherwise.
+*/
+MapKeyElement mapIteratorKey(const MapIterator *iterator);
+
+/**
+* mapIteratorData: Returns the data element the iterator points to. The data
+* element is not copied and still belongs to the map.
+*
+* @param iterator - The iterator in question
+* @return
+* 	NULL if a NULL pointer was sent or the iterator is not valid.
+* 	The current data element otherwise.
+*/
+MapDataElement mapIteratorData(const MapIterator *iterator);
+
+/**
+* mapIteratorNext: Advances the iterator to the next (greater) key of the map.
+* Does nothing if the iterator is not valid. An iterator returned by mapGetRange
+* becomes invalid when it passes the end of its range.
+*
+* @param iterator - The iterator to advance
+*/
+void mapIteratorNext(MapIterator *iterator);
+
 /**
 * mapClear: Removes all key and data elements from target map.
 * The elements are deallocated using the stored free functions.
@@ -232,6 +613,116 @@ MapKeyElement mapGetNext(Map map);
 */
 MapResult mapClear(Map map);
 
+/**
+* Counters of the work done by a map. Kept only when mtm_map/map.c is built
+* with MAP_STATS defined, otherwise the map does not count and all counters
+* stay 0.
+* Lookups count too, so the counters are updated with relaxed atomics and may
+* be kept while readers share the map (concurrent maps, read mostly maps).
+* A snapshot taken while other threads use the map is not consistent between
+* counters.
+*/
+typedef struct MapStats_t {
+    unsigned long finds;           // key lookups, by get, contains, put and remove
+    unsigned long nodes_visited;   // tree nodes searched by lookups
+    unsigned long comparisons;     // key comparisons
+    unsigned long index_probes;    // hash index slots probed
+    unsigned long allocations;     // nodes, keys and hash indexes allocated
+    unsigned long frees;           // nodes, keys and hash indexes freed
+    unsigned long iterator_steps;  // advances of internal and external iterators
+} MapStats;
+
+/**
+* mapGetStats: Returns the counters of the work the map did since it was
+* created or since the last mapResetStats.
+*
+* @param map - The map to inspect
+* @param stats - OUT the counters of the map
+* @return
+* 	MAP_NULL_ARGUMENT - if a NULL pointer was sent.
+* 	MAP_SUCCESS - Otherwise.
+*/
+MapResult mapGetStats(Map map, MapStats *stats);
+
+/**
+* mapResetStats: Zeroes the counters of the map.
+*
+* @param map - The map whose counters are zeroed
+* @return
+* 	MAP_NULL_ARGUMENT - if a NULL pointer was sent.
+* 	MAP_SUCCESS - Otherwise.
+*/
+MapResult mapResetStats(Map map);
+
+/**
+* Type of function for encoding a key or data element into bytes, for
+* mapSerialize. Gets the element, a buffer and its size, and returns the number
+* of bytes the encoding takes. If that is more than the size of the buffer the
+* buffer is left unused, and the function is called again with a big enough
+* buffer. Returns a negative number if the element can't be encoded.
+*/
+typedef int(*encodeMapElement)(void *, unsigned char *, int);
+
+/**
+* Type of function for decoding a key or data element from the bytes written
+* by its encodeMapElement, for mapDeserialize. Gets the bytes and their number,
+* and returns a newly allocated element, or NULL on failure.
+*/
+typedef void *(*decodeMapElement)(const unsigned char *, int);
+
+/**
+* mapSerialize: Writes the pairs of the map to a binary stream in ascending
+* key order. The stream holds the number of pairs followed by the pairs, and
+* every encoded element is prefixed by its length.
+*
+* @param map - The map to write
+* @param stream - Stream opened for binary writing
+* @param encodeKey - Function encoding a key element
+* @param encodeData - Function encoding a data element
+* @return
+* 	MAP_NULL_ARGUMENT - if a NULL pointer was sent.
+* 	MAP_OUT_OF_MEMORY - if an allocation failed.
+* 	MAP_ERROR - if an element could not be encoded or writing failed. Part
+* 	of the map may have been written in this case.
+* 	MAP_SUCCESS - Otherwise.
+*/
+MapResult mapSerialize(Map map,
+                       FILE *stream,
+                       encodeMapElement encodeKey,
+                       encodeMapElement encodeData);
+
+/**
+* mapDeserialize: Replaces the contents of a map with pairs read from a binary
+* stream written by mapSerialize. As the pairs are sorted, the map is built in
+* linear time. The decoded data elements are adopted by the map, the decoded
+* keys are copied into it and then freed with its key free function (for an
+* int keyed map, they must be allocated with malloc).
+*
+* @param map - The map to read into, created with the same functions and
+* 		compare function as the one written
+* @param stream - Stream opened for binary reading
+* @param decodeKey - Function decoding a key element
+* @param decodeData - Function decoding a data element
+* @return
+* 	MAP_NULL_ARGUMENT - if a NULL pointer was sent.
+* 	MAP_OUT_OF_MEMORY - if an allocation failed.
+* 	MAP_ERROR - if reading failed, or the stream is not a map written by
+* 	mapSerialize or its keys are not strictly ascending.
+* 	MAP_SUCCESS - Otherwise.
+* 	The map is left empty on failure.
+*/
+MapResult mapDeserialize(Map map,
+                         FILE *stream,
+                         decodeMapElement decodeKey,
+                         decodeMapElement decodeData);
+
+/**
+* mapEncodeInt, mapDecodeInt: Encoding of an int element as 4 bytes, usable as
+* encodeMapElement and decodeMapElement, e.g. for the keys of int keyed maps.
+*/
+int mapEncodeInt(void *element, unsigned char *buffer, int size);
+void *mapDecodeInt(const unsigned char *buffer, int size);
+
 /*!
 * Macro for iterating over a map.
 * Declares a new iterator for the loop.
@@ -241,4 +732,466 @@ MapResult mapClear(Map map);
         iterator ;\
         iterator = mapGetNext(map))
 
+/*!
+* Macro for iterating over a map with an external iterator.
+* Declares a new MapIterator for the loop, use mapIteratorKey and
+* mapIteratorData on its address to access the current element.
+*/
+#define MAP_ITERATE(iterator, map) \
+    for(MapIterator iterator = mapIteratorBegin(map) ; \
+        mapIteratorValid(&iterator) ;\
+        mapIteratorNext(&iterator))
+
+/*!
+* Macro for iterating over the keys of a map in the closed range [low, high].
+* Declares a new MapIterator for the loop, as MAP_ITERATE.
+*/
+#define MAP_ITERATE_RANGE(iterator, map, low, high) \
+    for(MapIterator iterator = mapGetRange(map, low, high) ; \
+        mapIteratorValid(&iterator) ;\
+        mapIteratorNext(&iterator))
+
+/**
+* Type specialized maps
+*
+* MAP_DEFINE(Name, KeyType, DataType, cmp) generates a map type Name which
+* stores its keys and data by value, in a B-tree of the same shape as Map.
+* cmp(a, b) compares two KeyType values and returns a negative number, zero or
+* a positive number as mapCompare functions do. It may be a function-like
+* macro (e.g. MAP_COMPARE_VALUES) or a function visible to the compiler, so
+* comparisons are inlined and no key is ever allocated.
+* The map never copies or frees its elements beyond assigning them, so a map
+* of pointers does not own what they point to.
+*
+* Expanding MAP_DEFINE(IntPlayerMap, int, Player, MAP_COMPARE_VALUES) defines:
+*   IntPlayerMap		- Pointer to the map
+*   IntPlayerMapCreate	- Creates a new empty map, NULL on allocation failure
+*   IntPlayerMapDestroy	- Deletes an existing map
+*   IntPlayerMapGetSize	- Returns the size of a map, -1 for NULL
+*   IntPlayerMapContains	- Returns weather or not a key exists inside the map
+*   IntPlayerMapGet		- Returns a pointer to the data of a key, or NULL.
+*   				  The pointer is valid until the map changes
+*   IntPlayerMapPut		- Gives a key a value, as mapPut
+*   IntPlayerMapRemove	- Removes a key, as mapRemove
+*   IntPlayerMapClear	- Removes all keys, as mapClear
+*   IntPlayerMapIterator	- External iterator type, with
+*   				  IntPlayerMapIteratorBegin, IntPlayerMapIteratorValid,
+*   				  IntPlayerMapIteratorKey, IntPlayerMapIteratorData
+*   				  (returning a pointer) and IntPlayerMapIteratorNext
+*
+* MAP_DEFINE_MIN_DEGREE may be defined before including map.h to change the
+* B-tree minimal degree of the generated maps.
+*/
+#ifndef MAP_DEFINE_MIN_DEGREE
+#define MAP_DEFINE_MIN_DEGREE 16
+#endif
+#define MAP_DEFINE_NODE_KEYS (2 * MAP_DEFINE_MIN_DEGREE - 1)
+
+/** Comparison for MAP_DEFINE of keys with the built in relational operators */
+#define MAP_COMPARE_VALUES(first, second) \
+    (((first) > (second)) - ((first) < (second)))
+
+#define MAP_DEFINE(Name, KeyType, DataType, cmp)                                \
+typedef struct Name##Node_t {                                                   \
+    int count;                                                                  \
+    bool leaf;                                                                  \
+    KeyType keys[MAP_DEFINE_NODE_KEYS];                                         \
+    DataType data[MAP_DEFINE_NODE_KEYS];                                        \
+    struct Name##Node_t *children[MAP_DEFINE_NODE_KEYS + 1];                    \
+} *Name##Node;                                                                  \
+                                                                                \
+typedef struct Name##_t {                                                       \
+    Name##Node root;                                                            \
+    int size;                                                                   \
+} *Name;                                                                        \
+                                                                                \
+typedef struct {                                                                \
+    Name##Node path[MAP_ITERATOR_MAX_DEPTH];                                    \
+    int path_index[MAP_ITERATOR_MAX_DEPTH];                                     \
+    int depth;                                                                  \
+} Name##Iterator;                                                               \
+                                                                                \
+static inline Name Name##Create(void)                                           \
+{                                                                               \
+    Name map = malloc(sizeof(*map));                                            \
+    if (NULL != map) {                                                          \
+        map->root = NULL;                                                       \
+        map->size = 0;                                                          \
+    }                                                                           \
+    return map;                                                                 \
+}                                                                               \
+                                                                                \
+static inline void Name##NodeFree(Name##Node node)                              \
+{                                                                               \
+    if (!node->leaf) {                                                          \
+        for (int i = 0; i <= node->count; i++) {                                \
+            Name##NodeFree(node->children[i]);                                  \
+        }                                                                       \
+    }                                                                           \
+    free(node);                                                                 \
+}                                                                               \
+                                                                                \
+static inline MapResult Name##Clear(Name map)                                   \
+{                                                                               \
+    if (NULL == map) {                                                          \
+        return MAP_NULL_ARGUMENT;                                               \
+    }                                                                           \
+    if (NULL != map->root) {                                                    \
+        Name##NodeFree(map->root);                                              \
+    }                                                                           \
+    map->root = NULL;                                                           \
+    map->size = 0;                                                              \
+    return MAP_SUCCESS;                                                         \
+}                                                                               \
+                                                                                \
+static inline void Name##Destroy(Name map)                                      \
+{                                                                               \
+    if (NULL != map) {                                                          \
+        Name##Clear(map);                                                       \
+        free(map);                                                              \
+    }                                                                           \
+}                                                                               \
+                                                                                \
+static inline int Name##GetSize(Name map)                                       \
+{                                                                               \
+    return (NULL == map) ? -1 : map->size;                                      \
+}                                                                               \
+                                                                                \
+static inline bool Name##NodeSearch(Name##Node node, KeyType key, int *index)   \
+{                                                                               \
+    int low = 0, high = node->count;                                            \
+    while (low < high) {                                                        \
+        int middle = low + (high - low) / 2;                                    \
+        if (cmp(node->keys[middle], key) < 0) {                                 \
+            low = middle + 1;                                                   \
+        } else {                                                                \
+            high = middle;                                                      \
+        }                                                                       \
+    }                                                                           \
+    *index = low;                                                               \
+    return (low < node->count) && (0 == cmp(node->keys[low], key));             \
+}                                                                               \
+                                                                                \
+static inline DataType *Name##Get(Name map, KeyType key)                        \
+{                                                                               \
+    Name##Node node = (NULL == map) ? NULL : map->root;                         \
+    while (NULL != node) {                                                      \
+        int index;                                                              \
+        if (Name##NodeSearch(node, key, &index)) {                              \
+            return &node->data[index];                                          \
+        }                                                                       \
+        node = node->leaf ? NULL : node->children[index];                       \
+    }                                                                           \
+    return NULL;                                                                \
+}                                                                               \
+                                                                                \
+static inline bool Name##Contains(Name map, KeyType key)                        \
+{                                                                               \
+    return NULL != Name##Get(map, key);                                         \
+}                                                                               \
+                                                                                \
+static inline Name##Node Name##NewNode(bool leaf)                               \
+{                                                                               \
+    Name##Node node = malloc(sizeof(*node));                                    \
+    if (NULL != node) {                                                         \
+        node->count = 0;                                                        \
+        node->leaf = leaf;                                                      \
+    }                                                                           \
+    return node;                                                                \
+}                                                                               \
+                                                                                \
+static inline void Name##SplitChild(Name##Node parent, int index,               \
+                                    Name##Node right)                           \
+{                                                                               \
+    Name##Node left = parent->children[index];                                  \
+    int half = MAP_DEFINE_MIN_DEGREE;                                           \
+    right->leaf = left->leaf;                                                   \
+    right->count = half - 1;                                                    \
+    for (int i = 0; i < half - 1; i++) {                                        \
+        right->keys[i] = left->keys[i + half];                                  \
+        right->data[i] = left->data[i + half];                                  \
+    }                                                                           \
+    if (!left->leaf) {                                                          \
+        for (int i = 0; i < half; i++) {                                        \
+            right->children[i] = left->children[i + half];                      \
+        }                                                                       \
+    }                                                                           \
+    left->count = half - 1;                                                     \
+    for (int i = parent->count; i > index; i--) {                               \
+        parent->keys[i] = parent->keys[i - 1];                                  \
+        parent->data[i] = parent->data[i - 1];                                  \
+        parent->children[i + 1] = parent->children[i];                          \
+    }                                                                           \
+    parent->keys[index] = left->keys[half - 1];                                 \
+    parent->data[index] = left->data[half - 1];                                 \
+    parent->children[index + 1] = right;                                        \
+    parent->count++;                                                            \
+}                                                                               \
+                                                                                \
+static inline MapResult Name##Put(Name map, KeyType key, DataType data)         \
+{                                                                               \
+    if (NULL == map) {                                                          \
+        return MAP_NULL_ARGUMENT;                                               \
+    }                                                                           \
+    if (NULL == map->root) {                                                    \
+        map->root = Name##NewNode(true);                                        \
+        if (NULL == map->root) {                                                \
+            return MAP_OUT_OF_MEMORY;                                           \
+        }                                                                       \
+    }                                                                           \
+    if (MAP_DEFINE_NODE_KEYS == map->root->count) {                             \
+        Name##Node root = Name##NewNode(false);                                 \
+        Name##Node right = Name##NewNode(false);                                \
+        if ((NULL == root) || (NULL == right)) {                                \
+            free(root);                                                         \
+            free(right);                                                        \
+            return MAP_OUT_OF_MEMORY;                                           \
+        }                                                                       \
+        root->children[0] = map->root;                                          \
+        Name##SplitChild(root, 0, right);                                       \
+        map->root = root;                                                       \
+    }                                                                           \
+    Name##Node node = map->root;                                                \
+    while (true) {                                                              \
+        int index;                                                              \
+        if (Name##NodeSearch(node, key, &index)) {                              \
+            node->data[index] = data;                                           \
+            return MAP_SUCCESS;                                                 \
+        }                                                                       \
+        if (node->leaf) {                                                       \
+            for (int i = node->count; i > index; i--) {                         \
+                node->keys[i] = node->keys[i - 1];                              \
+                node->data[i] = node->data[i - 1];                              \
+            }                                                                   \
+            node->keys[index] = key;                                            \
+            node->data[index] = data;                                           \
+            node->count++;                                                      \
+            map->size++;                                                        \
+            return MAP_SUCCESS;                                                 \
+        }                                                                       \
+        if (MAP_DEFINE_NODE_KEYS == node->children[index]->count) {             \
+            Name##Node right = Name##NewNode(false);                            \
+            if (NULL == right) {                                                \
+                return MAP_OUT_OF_MEMORY;                                       \
+            }                                                                   \
+            Name##SplitChild(node, index, right);                               \
+            int order = cmp(key, node->keys[index]);                            \
+            if (0 == order) {                                                   \
+                node->data[index] = data;                                       \
+                return MAP_SUCCESS;                                             \
+            }                                                                   \
+            index += (order > 0);                                               \
+        }                                                                       \
+        node = node->children[index];                                           \
+    }                                                                           \
+}                                                                               \
+                                                                                \
+static inline void Name##MergeChildren(Name##Node parent, int index)            \
+{                                                                               \
+    Name##Node left = parent->children[index];                                  \
+    Name##Node right = parent->children[index + 1];                             \
+    left->keys[left->count] = parent->keys[index];                              \
+    left->data[left->count] = parent->data[index];                              \
+    for (int i = 0; i < right->count; i++) {                                    \
+        left->keys[left->count + 1 + i] = right->keys[i];                       \
+        left->data[left->count + 1 + i] = right->data[i];                       \
+    }                                                                           \
+    if (!left->leaf) {                                                          \
+        for (int i = 0; i <= right->count; i++) {                               \
+            left->children[left->count + 1 + i] = right->children[i];           \
+        }                                                                       \
+    }                                                                           \
+    left->count += 1 + right->count;                                            \
+    for (int i = index; i < parent->count - 1; i++) {                           \
+        parent->keys[i] = parent->keys[i + 1];                                  \
+        parent->data[i] = parent->data[i + 1];                                  \
+        parent->children[i + 1] = parent->children[i + 2];                      \
+    }                                                                           \
+    parent->count--;                                                            \
+    free(right);                                                                \
+}                                                                               \
+                                                                                \
+static inline int Name##FillChild(Name##Node parent, int index)                 \
+{                                                                               \
+    Name##Node child = parent->children[index];                                 \
+    if (child->count >= MAP_DEFINE_MIN_DEGREE) {                                \
+        return index;                                                           \
+    }                                                                           \
+    if ((index > 0) &&                                                          \
+        (parent->children[index - 1]->count >= MAP_DEFINE_MIN_DEGREE)) {        \
+        Name##Node left = parent->children[index - 1];                          \
+        for (int i = child->count; i > 0; i--) {                                \
+            child->keys[i] = child->keys[i - 1];                                \
+            child->data[i] = child->data[i - 1];                                \
+        }                                                                       \
+        if (!child->leaf) {                                                     \
+            for (int i = child->count + 1; i > 0; i--) {                        \
+                child->children[i] = child->children[i - 1];                    \
+            }                                                                   \
+            child->children[0] = left->children[left->count];                   \
+        }                                                                       \
+        child->keys[0] = parent->keys[index - 1];                               \
+        child->data[0] = parent->data[index - 1];                               \
+        parent->keys[index - 1] = left->keys[left->count - 1];                  \
+        parent->data[index - 1] = left->data[left->count - 1];                  \
+        left->count--;                                                          \
+        child->count++;                                                         \
+        return index;                                                           \
+    }                                                                           \
+    if ((index < parent->count) &&                                              \
+        (parent->children[index + 1]->count >= MAP_DEFINE_MIN_DEGREE)) {        \
+        Name##Node right = parent->children[index + 1];                         \
+        child->keys[child->count] = parent->keys[index];                        \
+        child->data[child->count] = parent->data[index];                        \
+        if (!child->leaf) {                                                     \
+            child->children[child->count + 1] = right->children[0];             \
+            for (int i = 0; i < right->count; i++) {                            \
+                right->children[i] = right->children[i + 1];                    \
+            }                                                                   \
+        }                                                                       \
+        parent->keys[index] = right->keys[0];                                   \
+        parent->data[index] = right->data[0];                                   \
+        for (int i = 0; i < right->count - 1; i++) {                            \
+            right->keys[i] = right->keys[i + 1];                                \
+            right->data[i] = right->data[i + 1];                                \
+        }                                                                       \
+        right->count--;                                                         \
+        child->count++;                                                         \
+        return index;                                                           \
+    }                                                                           \
+    if (index < parent->count) {                                                \
+        Name##MergeChildren(parent, index);                                     \
+        return index;                                                           \
+    }                                                                           \
+    Name##MergeChildren(parent, index - 1);                                     \
+    return index - 1;                                                           \
+}                                                                               \
+                                                                                \
+static inline MapResult Name##NodeRemove(Name##Node node, KeyType key)          \
+{                                                                               \
+    while (true) {                                                              \
+        int index;                                                              \
+        bool found = Name##NodeSearch(node, key, &index);                       \
+        if (node->leaf) {                                                       \
+            if (!found) {                                                       \
+                return MAP_ITEM_DOES_NOT_EXIST;                                 \
+            }                                                                   \
+            for (int i = index; i < node->count - 1; i++) {                     \
+                node->keys[i] = node->keys[i + 1];                              \
+                node->data[i] = node->data[i + 1];                              \
+            }                                                                   \
+            node->count--;                                                      \
+            return MAP_SUCCESS;                                                 \
+        }                                                                       \
+        if (!found) {                                                           \
+            node = node->children[Name##FillChild(node, index)];                \
+            continue;                                                           \
+        }                                                                       \
+        Name##Node left = node->children[index];                                \
+        Name##Node right = node->children[index + 1];                           \
+        if (left->count >= MAP_DEFINE_MIN_DEGREE) {                             \
+            Name##Node predecessor = left;                                      \
+            while (!predecessor->leaf) {                                        \
+                predecessor = predecessor->children[predecessor->count];        \
+            }                                                                   \
+            key = predecessor->keys[predecessor->count - 1];                    \
+            node->keys[index] = key;                                            \
+            node->data[index] = predecessor->data[predecessor->count - 1];      \
+            node = left;                                                        \
+        } else if (right->count >= MAP_DEFINE_MIN_DEGREE) {                     \
+            Name##Node successor = right;                                       \
+            while (!successor->leaf) {                                          \
+                successor = successor->children[0];                             \
+            }                                                                   \
+            key = successor->keys[0];                                           \
+            node->keys[index] = key;                                            \
+            node->data[index] = successor->data[0];                             \
+            node = right;                                                       \
+        } else {                                                                \
+            Name##MergeChildren(node, index);                                   \
+            node = left;                                                        \
+        }                                                                       \
+    }                                                                           \
+}                                                                               \
+                                                                                \
+static inline MapResult Name##Remove(Name map, KeyType key)                     \
+{                                                                               \
+    if (NULL == map) {                                                          \
+        return MAP_NULL_ARGUMENT;                                               \
+    }                                                                           \
+    if (NULL == map->root) {                                                    \
+        return MAP_ITEM_DOES_NOT_EXIST;                                         \
+    }                                                                           \
+    MapResult result = Name##NodeRemove(map->root, key);                        \
+    if (0 == map->root->count) {                                                \
+        Name##Node root = map->root;                                            \
+        map->root = root->leaf ? NULL : root->children[0];                      \
+        free(root);                                                             \
+    }                                                                           \
+    if (MAP_SUCCESS == result) {                                                \
+        map->size--;                                                            \
+    }                                                                           \
+    return result;                                                              \
+}                                                                               \
+                                                                                \
+static inline void Name##IteratorDescend(Name##Iterator *iterator,              \
+                                         Name##Node node)                       \
+{                                                                               \
+    while (true) {                                                              \
+        iterator->path[iterator->depth] = node;                                 \
+        iterator->path_index[iterator->depth] = 0;                              \
+        iterator->depth++;                                                      \
+        if (node->leaf) {                                                       \
+            return;                                                             \
+        }                                                                       \
+        node = node->children[0];                                               \
+    }                                                                           \
+}                                                                               \
+                                                                                \
+static inline Name##Iterator Name##IteratorBegin(Name map)                      \
+{                                                                               \
+    Name##Iterator iterator;                                                    \
+    iterator.depth = 0;                                                         \
+    if ((NULL != map) && (NULL != map->root) && (map->root->count > 0)) {       \
+        Name##IteratorDescend(&iterator, map->root);                            \
+    }                                                                           \
+    return iterator;                                                            \
+}                                                                               \
+                                                                                \
+static inline bool Name##IteratorValid(const Name##Iterator *iterator)          \
+{                                                                               \
+    return (NULL != iterator) && (iterator->depth > 0);                         \
+}                                                                               \
+                                                                                \
+static inline KeyType Name##IteratorKey(const Name##Iterator *iterator)         \
+{                                                                               \
+    int top = iterator->depth - 1;                                              \
+    return iterator->path[top]->keys[iterator->path_index[top]];                \
+}                                                                               \
+                                                                                \
+static inline DataType *Name##IteratorData(const Name##Iterator *iterator)      \
+{                                                                               \
+    int top = iterator->depth - 1;                                              \
+    return &iterator->path[top]->data[iterator->path_index[top]];               \
+}                                                                               \
+                                                                                \
+static inline void Name##IteratorNext(Name##Iterator *iterator)                 \
+{                                                                               \
+    if (!Name##IteratorValid(iterator)) {                                       \
+        return;                                                                 \
+    }                                                                           \
+    int top = iterator->depth - 1;                                              \
+    Name##Node node = iterator->path[top];                                      \
+    int index = ++iterator->path_index[top];                                    \
+    if (!node->leaf) {                                                          \
+        Name##IteratorDescend(iterator, node->children[index]);                 \
+        return;                                                                 \
+    }                                                                           \
+    while ((iterator->depth > 0) &&                                             \
+           (iterator->path_index[iterator->depth - 1] >=                        \
+            iterator->path[iterator->depth - 1]->count)) {                      \
+        iterator->depth--;                                                      \
+    }                                                                           \
+}
+
 #endif /* MAP_H_ */
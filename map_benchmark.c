@@ -0,0 +1,272 @@
+/**
+ * Map microbenchmark
+ *
+ * Measures mapPut, mapGet, mapRemove, mapCopy and a full iteration
+ * (mapGetFirst/mapGetNext) at sizes from 10 up to 10^7, with sequential,
+ * random and Zipf distributed key orders. Only the original map.h interface
+ * is used, so the same source runs against both implementations:
+ *
+ *   gcc -std=c99 -O2 -DNDEBUG -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc \
+ *       -I. map_benchmark.c mtm_map/map.c -lm -o bench_mtm
+ *   gcc -std=c99 -O2 -DNDEBUG -DBENCH_LIBMAP \
+ *       -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc \
+ *       -I. map_benchmark.c -L. -lmap -lm -o bench_libmap
+ *
+ *   ./bench_mtm [max size] >> bench_output.txt
+ *
+ * Every measurement is printed to stdout as a CSV line:
+ *   implementation,operation,order,size,ns_per_op,allocs_per_op
+ * An op is a single element in every row: a mapCopy of n elements counts as
+ * n ops, like n calls to mapPut.
+ * Allocations are the calls to malloc, calloc and realloc, counted through
+ * the linker's --wrap option. They include the allocations of the copy
+ * functions below, which are the same for both implementations.
+ *
+ * The reference libmap.a returns its own keys from mapGetFirst and mapGetNext
+ * instead of copies, so BENCH_LIBMAP also stops the iteration from freeing
+ * them.
+ *
+ * The time of the next size is predicted from the growth between the last
+ * two sizes, and an implementation stops growing once that prediction passes
+ * BENCH_TIME_LIMIT seconds, so quadratic implementations finish as well.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include "map.h"
+
+#ifdef BENCH_LIBMAP
+#define BENCH_IMPLEMENTATION "libmap"
+#define BENCH_FREE_ITERATED_KEY(key)
+#else
+#define BENCH_IMPLEMENTATION "mtm_map"
+#define BENCH_FREE_ITERATED_KEY(key) freeInt(key)
+#endif
+
+#define BENCH_MIN_SIZE 10
+#define BENCH_MAX_SIZE 10000000
+#define BENCH_TIME_LIMIT 120.0
+
+/**
+ * Small sizes are repeated until about BENCH_MIN_OPERATIONS operations were
+ * timed, or BENCH_MIN_TIME seconds passed
+ */
+#define BENCH_MIN_OPERATIONS 1000000
+#define BENCH_MIN_TIME 0.5
+
+typedef enum {
+  ORDER_SEQUENTIAL,
+  ORDER_RANDOM,
+  ORDER_ZIPF
+} KeyOrder;
+
+static const char *order_names[] = {"sequential", "random", "zipf"};
+
+static unsigned long allocations = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *pointer, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+  allocations++;
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+  allocations++;
+  return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *pointer, size_t size)
+{
+  allocations++;
+  return __real_realloc(pointer, size);
+}
+
+static MapDataElement copyInt(MapDataElement element)
+{
+  int *copy = malloc(sizeof(*copy));
+  if (NULL != copy) {
+    *copy = *(int *)element;
+  }
+  return copy;
+}
+
+static void freeInt(MapDataElement element)
+{
+  free(element);
+}
+
+static int compareInts(MapKeyElement first, MapKeyElement second)
+{
+  int a = *(int *)first, b = *(int *)second;
+  return (a > b) - (a < b);
+}
+
+/** xorshift64*, deterministic so both implementations see the same keys */
+static unsigned long long random_state = 88172645463325252ULL;
+
+static unsigned long long nextRandom(void)
+{
+  random_state ^= random_state >> 12;
+  random_state ^= random_state << 25;
+  random_state ^= random_state >> 27;
+  return random_state * 2685821657736338717ULL;
+}
+
+/**
+ * Fills keys with size keys in the given order. Zipf keys (s = 1) are drawn
+ * by inverting the continuous approximation of the distribution, and their
+ * ranks are scattered over the key range so the hot keys are not adjacent.
+ */
+static void generateKeys(int *keys, int size, KeyOrder order)
+{
+  for (int i = 0; i < size; i++) {
+    keys[i] = i;
+  }
+
+  if (ORDER_RANDOM == order) {
+    for (int i = size - 1; i > 0; i--) {
+      int j = (int)(nextRandom() % (unsigned long long)(i + 1));
+      int temp = keys[i];
+      keys[i] = keys[j];
+      keys[j] = temp;
+    }
+  } else if (ORDER_ZIPF == order) {
+    for (int i = 0; i < size; i++) {
+      double uniform = (double)(nextRandom() >> 11) / 9007199254740992.0;
+      long rank = (long)exp(uniform * log((double)size + 1)) - 1;
+      keys[i] = (int)((unsigned long long)rank * 2654435761ULL %
+                      (unsigned long long)size);
+    }
+  }
+}
+
+static double now(void)
+{
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+static void report(const char *operation, KeyOrder order, int size,
+                   double seconds, unsigned long allocated, double operations)
+{
+  printf("%s,%s,%s,%d,%.2f,%.3f\n", BENCH_IMPLEMENTATION, operation,
+         order_names[order], size, seconds * 1e9 / operations,
+         (double)allocated / operations);
+}
+
+/**
+ * Runs all operations on a map of the given size.
+ *
+ * @return
+ *    The time all operations took, per repetition.
+ */
+static double benchmarkSize(const int *keys, int size, KeyOrder order)
+{
+  int repetitions = 0;
+  double put = 0, get = 0, iterate = 0, copy = 0, remove = 0;
+  unsigned long put_allocs = 0, get_allocs = 0, iterate_allocs = 0;
+  unsigned long copy_allocs = 0, remove_allocs = 0;
+  volatile long checksum = 0;
+
+  do {
+    Map map = mapCreate(copyInt, copyInt, freeInt, freeInt, compareInts);
+    unsigned long start_allocs = allocations;
+    double start = now();
+    for (int i = 0; i < size; i++) {
+      mapPut(map, (MapKeyElement)&keys[i], (MapDataElement)&keys[i]);
+    }
+    put += now() - start;
+    put_allocs += allocations - start_allocs;
+
+    start_allocs = allocations;
+    start = now();
+    for (int i = 0; i < size; i++) {
+      checksum += *(int *)mapGet(map, (MapKeyElement)&keys[i]);
+    }
+    get += now() - start;
+    get_allocs += allocations - start_allocs;
+
+    start_allocs = allocations;
+    start = now();
+    for (MapKeyElement key = mapGetFirst(map); NULL != key;
+         key = mapGetNext(map)) {
+      checksum += *(int *)key;
+      BENCH_FREE_ITERATED_KEY(key);
+    }
+    iterate += now() - start;
+    iterate_allocs += allocations - start_allocs;
+
+    start_allocs = allocations;
+    start = now();
+    Map copied = mapCopy(map);
+    copy += now() - start;
+    copy_allocs += allocations - start_allocs;
+    mapDestroy(copied);
+
+    start_allocs = allocations;
+    start = now();
+    for (int i = 0; i < size; i++) {
+      mapRemove(map, (MapKeyElement)&keys[i]);
+    }
+    remove += now() - start;
+    remove_allocs += allocations - start_allocs;
+
+    mapDestroy(map);
+    repetitions++;
+  } while (((long)repetitions * size < BENCH_MIN_OPERATIONS) &&
+           (put + get + iterate + copy + remove < BENCH_MIN_TIME));
+
+  double operations = (double)repetitions * size;
+  report("put", order, size, put, put_allocs, operations);
+  report("get", order, size, get, get_allocs, operations);
+  report("iterate", order, size, iterate, iterate_allocs, operations);
+  report("copy", order, size, copy, copy_allocs, operations);
+  report("remove", order, size, remove, remove_allocs, operations);
+  fflush(stdout);
+
+  return (put + get + iterate + copy + remove) / repetitions;
+}
+
+int main(int argc, char *argv[])
+{
+  long max_size = (argc > 1) ? strtol(argv[1], NULL, 10) : BENCH_MAX_SIZE;
+  if ((max_size < BENCH_MIN_SIZE) || (max_size > BENCH_MAX_SIZE)) {
+    fprintf(stderr, "Usage: %s [max size, %d to %d]\n", argv[0],
+            BENCH_MIN_SIZE, BENCH_MAX_SIZE);
+    return 1;
+  }
+
+  int *keys = malloc(sizeof(*keys) * max_size);
+  if (NULL == keys) {
+    fprintf(stderr, "Out of memory\n");
+    return 1;
+  }
+
+  printf("implementation,operation,order,size,ns_per_op,allocs_per_op\n");
+  for (KeyOrder order = ORDER_SEQUENTIAL; order <= ORDER_ZIPF; order++) {
+    double previous = 0;
+    for (long size = BENCH_MIN_SIZE; size <= max_size; size *= 10) {
+      generateKeys(keys, (int)size, order);
+      double current = benchmarkSize(keys, (int)size, order);
+      double growth = (previous > 0) ? current / previous : 10;
+      if ((size < max_size) && (current * growth > BENCH_TIME_LIMIT)) {
+        fprintf(stderr, "%s: stopping %s keys at size %ld\n",
+                BENCH_IMPLEMENTATION, order_names[order], size);
+        break;
+      }
+      previous = current;
+    }
+  }
+
+  free(keys);
+  return 0;
+}
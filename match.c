@@ -5,18 +5,162 @@
 struct match_t {
   Player first;
   Player second;
-  Player winner;
+  Winner result; //seat of the winner, so it outlives a removed participant
   Tournament tournament;
   int duration;
+  //positions of the match in the vectors holding it, see MatchHook
+  int system_position;
+  int tournament_position;
+  int first_position;
+  int second_position;
+  struct match_t *next_free; //next destroyed match of the arena, for reuse
 };
 
+#define MATCH_ARENA_FIRST_BLOCK 16
+#define MATCH_ARENA_MAX_BLOCK 4096
+
+/**
+ * A block of matches. Blocks grow geometrically up to MATCH_ARENA_MAX_BLOCK
+ * matches, so a tournament of n matches takes O(log n + n / MAX) mallocs.
+ */
+typedef struct match_block_t {
+  struct match_block_t *next;
+  int used;
+  int capacity;
+  struct match_t matches[];
+} *MatchBlock;
+
+struct match_arena_t {
+  MatchBlock blocks; //newest first
+  Match free_matches; //destroyed matches, linked through next_free
+};
+
+/**
+ * Takes memory for a match from the arena, reusing destroyed matches first
+ * 
+ * @param arena MatchArena in question
+ * @return
+ *    NULL if memory failure occured
+ *    uninitialized Match otherwise
+ */
+static Match matchArenaAllocate(MatchArena arena)
+{
+  if(arena == NULL)
+  {
+    return NULL;
+  }
+  if(arena->free_matches != NULL)
+  {
+    Match match = arena->free_matches;
+    arena->free_matches = match->next_free;
+    return match;
+  }
+  MatchBlock block = arena->blocks;
+  if(block == NULL || block->used == block->capacity)
+  {
+    int capacity = MATCH_ARENA_FIRST_BLOCK;
+    if(block != NULL)
+    {
+      capacity = block->capacity * 2;
+    }
+    if(capacity > MATCH_ARENA_MAX_BLOCK)
+    {
+      capacity = MATCH_ARENA_MAX_BLOCK;
+    }
+    block = (MatchBlock)malloc(sizeof(*block) + sizeof(struct match_t) * capacity);
+    if(block == NULL)
+    {
+      return NULL;
+    }
+    block->used = 0;
+    block->capacity = capacity;
+    block->next = arena->blocks;
+    arena->blocks = block;
+  }
+  return &block->matches[block->used++];
+}
+
+MatchArena matchArenaCreate()
+{
+  MatchArena arena = (MatchArena)malloc(sizeof(*arena));
+  if(arena == NULL)
+  {
+    return NULL;
+  }
+  arena->blocks = NULL;
+  arena->free_matches = NULL;
+  return arena;
+}
+
+void matchArenaDestroy(MatchArena arena)
+{
+  if(arena == NULL)
+  {
+    return;
+  }
+  while(arena->blocks != NULL)
+  {
+    MatchBlock next = arena->blocks->next;
+    free(arena->blocks);
+    arena->blocks = next;
+  }
+  free(arena);
+}
+
+/**
+ * Marks the match as not being held in any vector
+ */
+static void matchClearHooks(Match match)
+{
+  match->system_position = -1;
+  match->tournament_position = -1;
+  match->first_position = -1;
+  match->second_position = -1;
+}
+
+/**
+ * Counts the result of the match for the participants holding it in their
+ * records, or takes it out of their running totals
+ */
+static void matchCountResult(Match match, bool count)
+{
+  if(match->first_position >= 0)
+  {
+    playerCountResult(match->first, match, count);
+  }
+  if(match->second_position >= 0)
+  {
+    playerCountResult(match->second, match, count);
+  }
+}
+
+/**
+ * Gets the seat of a participant in the match
+ * 
+ * @param match Match in question
+ * @param winner winning participant, NULL for a draw
+ * @return FIRST_PLAYER or SECOND_PLAYER, DRAW if winner is not a participant
+ */
+static Winner matchGetSeat(Match match, Player winner)
+{
+  if(winner != NULL && winner == match->first)
+  {
+    return FIRST_PLAYER;
+  }
+  if(winner != NULL && winner == match->second)
+  {
+    return SECOND_PLAYER;
+  }
+  return DRAW;
+}
+
 Match matchCreate(Player first_player, Player second_player, Player winner, Tournament tournament, int duration)
 {
   if(first_player == NULL || second_player == NULL || tournament == NULL)
   {
     return NULL;
   }
-  if(duration == NULL || duration < 0)
+  if(duration < 0)
   {
     return NULL;
   }
@@ -24,16 +168,17 @@ Match matchCreate(Player first_player, Player second_player, Player winner, Tour
   {
     return NULL;
   }
-  Match match = (Match)malloc(sizeof(*match));
+  Match match = matchArenaAllocate(tournamentGetMatchArena(tournament));
   if(match == NULL)
   {
     return NULL;
   }
   match->first = first_player;
   match->second = second_player;
-  match->winner = winner;
+  match->result = matchGetSeat(match, winner);
   match->tournament = tournament;
   match->duration = duration;
+  matchClearHooks(match);
   return match;
 }
 
@@ -46,13 +191,14 @@ Player matchGetFirst(Match match)
   return match->first;
 }
 
-Player matchGetSecond(Match match);
+Player matchGetSecond(Match match)
 {
   if(match == NULL)
   {
     return NULL;
   }
   return match->second;
+}
 
 ChessResult matchSetWinner(Match match, Player winner)
 {
@@ -60,23 +206,14 @@ ChessResult matchSetWinner(Match match, Player winner)
   {
     return CHESS_NULL_ARGUMENT;
   }
-  if(winner == NULL) //if it was a draw
-  {
-    match->winner = NULL;
-    return CHESS_SUCCESS;
-  }
-  if(!matchIsParticipant(match, winner)) //if winner is not one of the players
+  if(winner != NULL && !matchIsParticipant(match, winner)) //if winner is not one of the players
   {
     return CHESS_PLAYER_NOT_EXIST;
   }
-  if(winner == match->first)
-  {
-    match->winner = match->first;
-  }
-  else
-  {
-    match->winner = match->second;
-  }
+  //the participants keep running totals of their results, so the old result is taken out of them
+  matchCountResult(match, false);
+  match->result = matchGetSeat(match, winner); //DRAW if winner is NULL
+  matchCountResult(match, true);
   return CHESS_SUCCESS;
 }
 
@@ -88,8 +225,7 @@ ChessResult matchSetLoser(Match match, Player loser)
   }
   if(loser == NULL)
   {
-    match->winner = NULL;
-    return CHESS_SUCCESS;
+    return matchSetWinner(match, NULL);
   }
   if(!matchIsParticipant(match, loser)) //if loser is not one of the players
   {
@@ -117,15 +253,52 @@ bool matchIsParticipant(Match match, Player player)
 
 ChessResult matchGetWinner(Match match, Player *winner)
 {
-  if(match == NULL)
+  if(match == NULL || winner == NULL)
   {
-    winner = NULL;
     return CHESS_NULL_ARGUMENT;
   }
-  winner = match->winner;
+  switch(match->result)
+  {
+  case FIRST_PLAYER:
+    *winner = match->first;
+    break;
+  case SECOND_PLAYER:
+    *winner = match->second;
+    break;
+  default:
+    *winner = NULL;
+  }
   return CHESS_SUCCESS;
 }
 
+Winner matchGetResult(Match match)
+{
+  if(match == NULL)
+  {
+    return DRAW;
+  }
+  return match->result;
+}
+
+void matchRemovePlayer(Match match, Player player)
+{
+  if(match == NULL || player == NULL)
+  {
+    return;
+  }
+  //the result stays with the seat, only the player is taken out of it
+  if(match->first == player)
+  {
+    match->first = NULL;
+    match->first_position = -1;
+  }
+  else if(match->second == player)
+  {
+    match->second = NULL;
+    match->second_position = -1;
+  }
+}
+
 int matchGetDuration(Match match)
 {
   if(match == NULL)
@@ -144,14 +317,43 @@ Tournament matchGetTournament(Match match)
   return match->tournament;
 }
 
+int *matchGetHook(Match match, MatchHook hook, Player player)
+{
+  if(match == NULL)
+  {
+    return NULL;
+  }
+  switch(hook)
+  {
+  case MATCH_HOOK_SYSTEM:
+    return &match->system_position;
+  case MATCH_HOOK_TOURNAMENT:
+    return &match->tournament_position;
+  case MATCH_HOOK_PLAYER:
+    if(player == match->first)
+    {
+      return &match->first_position;
+    }
+    if(player == match->second)
+    {
+      return &match->second_position;
+    }
+    return NULL;
+  default:
+    return NULL;
+  }
+}
+
 void matchDestroy(Match match)
 {
   if(match == NULL)
   {
     return;
   }
-  tournamentRemoveMatch(match->tournament, match);
-  free(match);
+  //the memory stays in the arena until the tournament is destroyed
+  MatchArena arena = tournamentGetMatchArena(match->tournament);
+  match->next_free = arena->free_matches;
+  arena->free_matches = match;
 }
 
 bool isSamePlayers(Match match1, Match match2)
@@ -178,7 +380,7 @@ int matchCompare(Match match1, Match match2)
   {
     return -1;
   }
-  if(match1->winner != match2->winner || match1->duration != match2->duration || 
+  if(match1->result != match2->result || match1->duration != match2->duration || 
   match1->tournament != match2->tournament)
   {
     return -1;
@@ -193,15 +395,16 @@ Match matchCopy(Match original)
   {
     return NULL;
   }
-  Match match = (Match)malloc(sizeof(*match));
+  Match match = matchArenaAllocate(tournamentGetMatchArena(original->tournament));
   if(match == NULL)
   {
     return NULL;
   }
   match->first = original->first;
   match->second = original->second;
-  match->winner = original->winner;
+  match->result = original->result;
   match->duration = original->duration;
   match->tournament = original->tournament;
+  matchClearHooks(match); //the copy is in no vector yet
   return match;
 }
\ No newline at end of file
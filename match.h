@@ -2,14 +2,52 @@
 #define _MATCH_H
 
 #include <stdbool.h>
+
+typedef struct match_t *Match;
+
+/**
+ * The vectors a Match may be held in. A match keeps its position in each of
+ * them, so it can be removed from all of them in O(1) (see MatchVector).
+ */
+typedef enum {
+  MATCH_HOOK_NONE, //a vector which doesn't track the positions of its matches
+  MATCH_HOOK_SYSTEM, //the chess system's vector of all matches
+  MATCH_HOOK_TOURNAMENT, //the vector of the match's tournament
+  MATCH_HOOK_PLAYER //the vector of one of the participants
+} MatchHook;
+
+/**
+ * Memory of the Matches of a single tournament. Matches are carved out of
+ * blocks holding many matches each, and the whole arena is released at once
+ * when the tournament is destroyed.
+ */
+typedef struct match_arena_t *MatchArena;
+
+// the headers below refer back to Match, so it is declared before them
 #include "chessSystem.h"
 #include "tournament.h"
 #include "player.h"
 
-typedef struct match_t *Match;
+/**
+ * Creates a new empty MatchArena. No block is allocated until the first
+ * match is created in it.
+ * 
+ * @return
+ *    NULL if memory failure occured
+ *    new MatchArena otherwise
+ */
+MatchArena matchArenaCreate();
+
+/**
+ * Destroys the arena and frees the memory of all the Matches created in it,
+ * which must no longer be used.
+ * 
+ * @param arena MatchArena to destroy
+ */
+void matchArenaDestroy(MatchArena arena);
 
 /**
- * Creates new Match instance
+ * Creates new Match instance, in the MatchArena of its tournament
  * 
  * @param first_player first participant
  * @param second_player second participant
@@ -82,7 +120,8 @@ bool matchIsParticipant(Match match, Player player);
 
 /**
  * @brief Get the winner of the match.
- * winner will be NULL if result != CHESS_SUCCESS or match ended in a draw
+ * winner will be NULL if result != CHESS_SUCCESS, match ended in a draw or
+ * the winner was removed from the system (see matchGetResult)
  * 
  * @param match Match in question
  * @param winner OUT for the found parameter
@@ -92,6 +131,24 @@ bool matchIsParticipant(Match match, Player player);
  */
 ChessResult matchGetWinner(Match match, Player *winner);
 
+/**
+ * Gets the result of the match by the seats of the participants. The result
+ * is kept when a participant is removed from the match.
+ * 
+ * @param match Match in question
+ * @return FIRST_PLAYER, SECOND_PLAYER or DRAW (also if match is NULL)
+ */
+Winner matchGetResult(Match match);
+
+/**
+ * Takes a player who is removed from the system out of the match. The seat of
+ * the player is left empty (NULL) and the result of the match is kept.
+ * 
+ * @param match Match in question
+ * @param player participant to remove, nothing is done if he doesn't take part
+ */
+void matchRemovePlayer(Match match, Player player);
+
 /**
  * Gets the duration of the match, in seconds.
  * 
@@ -103,7 +160,22 @@ ChessResult matchGetWinner(Match match, Player *winner);
 int matchGetDuration(Match match);
 
 /**
- * Destorys match instance and frees all private memory
+ * Gets the position of the match in one of the vectors holding it.
+ * 
+ * @param match Match in question
+ * @param hook kind of the vector
+ * @param player participant owning the vector, for MATCH_HOOK_PLAYER
+ * @return
+ *    Pointer to the position of the match in the vector (-1 if not in it)
+ *    NULL if NULL arguments were provided, hook is MATCH_HOOK_NONE or player
+ *    is not a participant
+ */
+int *matchGetHook(Match match, MatchHook hook, Player player);
+
+/**
+ * Destorys match instance and returns its memory to the tournament's arena.
+ * The match must already be removed from the vectors holding it. Destroying
+ * the tournament frees all of its matches, without destroying them one by one.
  * 
  * @param Match Match to be destroyed
  */
@@ -142,7 +214,8 @@ bool isSamePlayers(Match match1, Match match2);
 int matchCompare(Match match1, Match match2);
 
 /**
- * Creates a copy of the provided Match for the Map object.
+ * Creates a copy of the provided Match for the Map object, in the arena of
+ * the same tournament.
  * 
  * @param original Match to be copied
  * @return 
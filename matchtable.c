@@ -0,0 +1,328 @@
+#include <stdlib.h>
+#include <string.h>
+#include "matchtable.h"
+#include "match.h"
+#include "player.h"
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+/**
+ * The columns share a single allocation: the three int32 columns first, then
+ * the outcomes, so every column is a dense array of its own.
+ */
+struct match_table_t
+{
+  int32_t *first;     // id of the first participant
+  int32_t *second;    // id of the second participant
+  int32_t *duration;
+  uint8_t *outcome;   // MatchTableOutcome
+  int size;
+};
+
+/**
+ * Gets the outcome of a match, relative to its participants
+ * 
+ * @param match Match in question
+ * @return the MatchTableOutcome of the match
+ */
+static uint8_t matchTableOutcome(Match match);
+
+#if defined(__AVX2__)
+/**
+ * Sums the 32 bit lanes of a vector
+ */
+static int sumLanes(__m256i lanes);
+#elif defined(__SSE4_1__)
+/**
+ * Sums the 32 bit lanes of a vector
+ */
+static int sumLanes(__m128i lanes);
+
+/**
+ * Loads 4 outcomes, widened to 32 bit lanes
+ */
+static __m128i loadOutcomes(const uint8_t *outcome);
+#endif
+
+MatchTable matchTableCreate(MatchVector matches)
+{
+  if (NULL == matches) {
+    return NULL;
+  }
+
+  MatchTable table = (MatchTable)malloc(sizeof(*table));
+  if (NULL == table) {
+    return NULL;
+  }
+
+  table->size = matchVectorGetSize(matches);
+  table->first = NULL;
+  table->second = NULL;
+  table->duration = NULL;
+  table->outcome = NULL;
+  if (0 == table->size) {
+    return table;
+  }
+
+  int32_t *columns = (int32_t *)malloc(table->size * (3 * sizeof(int32_t) +
+                                                      sizeof(uint8_t)));
+  if (NULL == columns) {
+    free(table);
+    return NULL;
+  }
+
+  table->first = columns;
+  table->second = columns + table->size;
+  table->duration = columns + 2 * table->size;
+  table->outcome = (uint8_t *)(columns + 3 * table->size);
+
+  // the only pass which follows the pointers of the matches
+  Match *data = matchVectorData(matches);
+  for (int i = 0; i < table->size; i++) {
+    table->first[i] = playerGetId(matchGetFirst(data[i]));
+    table->second[i] = playerGetId(matchGetSecond(data[i]));
+    table->duration[i] = matchGetDuration(data[i]);
+    table->outcome[i] = matchTableOutcome(data[i]);
+  }
+
+  return table;
+}
+
+int matchTableGetSize(MatchTable table)
+{
+  return (NULL == table) ? 0 : table->size;
+}
+
+ChessResult matchTableCountResults(MatchTable table, int player_id,
+                                   MatchTableResults *results)
+{
+  if ((NULL == table) || (NULL == results)) {
+    return CHESS_NULL_ARGUMENT;
+  }
+
+  int i = 0;
+  int wins = 0, draws = 0, games = 0;
+
+  // a lane is all ones where the condition holds, so subtracting a mask
+  // counts the matches it holds for
+#if defined(__AVX2__)
+  __m256i id = _mm256_set1_epi32(player_id);
+  __m256i draw = _mm256_setzero_si256();
+  __m256i first_won = _mm256_set1_epi32(MATCH_TABLE_FIRST_WON);
+  __m256i second_won = _mm256_set1_epi32(MATCH_TABLE_SECOND_WON);
+  __m256i win_lanes = _mm256_setzero_si256();
+  __m256i draw_lanes = _mm256_setzero_si256();
+  __m256i game_lanes = _mm256_setzero_si256();
+
+  for (; i + 8 <= table->size; i += 8) {
+    __m256i is_first = _mm256_cmpeq_epi32(id,
+        _mm256_loadu_si256((const __m256i *)(table->first + i)));
+    __m256i is_second = _mm256_cmpeq_epi32(id,
+        _mm256_loadu_si256((const __m256i *)(table->second + i)));
+    __m256i outcome = _mm256_cvtepu8_epi32(
+        _mm_loadl_epi64((const __m128i *)(table->outcome + i)));
+
+    __m256i played = _mm256_or_si256(is_first, is_second);
+    __m256i won = _mm256_or_si256(
+        _mm256_and_si256(is_first, _mm256_cmpeq_epi32(outcome, first_won)),
+        _mm256_and_si256(is_second, _mm256_cmpeq_epi32(outcome, second_won)));
+    __m256i drew = _mm256_and_si256(played, _mm256_cmpeq_epi32(outcome, draw));
+
+    win_lanes = _mm256_sub_epi32(win_lanes, won);
+    draw_lanes = _mm256_sub_epi32(draw_lanes, drew);
+    game_lanes = _mm256_sub_epi32(game_lanes, played);
+  }
+
+  wins = sumLanes(win_lanes);
+  draws = sumLanes(draw_lanes);
+  games = sumLanes(game_lanes);
+#elif defined(__SSE4_1__)
+  __m128i id = _mm_set1_epi32(player_id);
+  __m128i draw = _mm_setzero_si128();
+  __m128i first_won = _mm_set1_epi32(MATCH_TABLE_FIRST_WON);
+  __m128i second_won = _mm_set1_epi32(MATCH_TABLE_SECOND_WON);
+  __m128i win_lanes = _mm_setzero_si128();
+  __m128i draw_lanes = _mm_setzero_si128();
+  __m128i game_lanes = _mm_setzero_si128();
+
+  for (; i + 4 <= table->size; i += 4) {
+    __m128i is_first = _mm_cmpeq_epi32(id,
+        _mm_loadu_si128((const __m128i *)(table->first + i)));
+    __m128i is_second = _mm_cmpeq_epi32(id,
+        _mm_loadu_si128((const __m128i *)(table->second + i)));
+    __m128i outcome = loadOutcomes(table->outcome + i);
+
+    __m128i played = _mm_or_si128(is_first, is_second);
+    __m128i won = _mm_or_si128(
+        _mm_and_si128(is_first, _mm_cmpeq_epi32(outcome, first_won)),
+        _mm_and_si128(is_second, _mm_cmpeq_epi32(outcome, second_won)));
+    __m128i drew = _mm_and_si128(played, _mm_cmpeq_epi32(outcome, draw));
+
+    win_lanes = _mm_sub_epi32(win_lanes, won);
+    draw_lanes = _mm_sub_epi32(draw_lanes, drew);
+    game_lanes = _mm_sub_epi32(game_lanes, played);
+  }
+
+  wins = sumLanes(win_lanes);
+  draws = sumLanes(draw_lanes);
+  games = sumLanes(game_lanes);
+#endif
+
+  // the matches left over by the vector loop, or all of them without SIMD
+  for (; i < table->size; i++) {
+    bool is_first = (table->first[i] == player_id);
+    bool is_second = (table->second[i] == player_id);
+    if (!is_first && !is_second) {
+      continue;
+    }
+
+    games++;
+    if (MATCH_TABLE_DRAW == table->outcome[i]) {
+      draws++;
+    } else if ((is_first && (MATCH_TABLE_FIRST_WON == table->outcome[i])) ||
+               (is_second && (MATCH_TABLE_SECOND_WON == table->outcome[i]))) {
+      wins++;
+    }
+  }
+
+  results->wins = wins;
+  results->draws = draws;
+  results->losses = games - wins - draws;
+  return CHESS_SUCCESS;
+}
+
+double matchTableAverageDuration(MatchTable table)
+{
+  if ((NULL == table) || (0 == table->size)) {
+    return 0;
+  }
+
+  int i = 0;
+  int64_t total = 0;
+
+  // durations are summed in 64 bit lanes, so millions of games can't overflow
+#if defined(__AVX2__)
+  __m256i sums = _mm256_setzero_si256();
+  for (; i + 4 <= table->size; i += 4) {
+    sums = _mm256_add_epi64(sums, _mm256_cvtepi32_epi64(
+        _mm_loadu_si128((const __m128i *)(table->duration + i))));
+  }
+
+  int64_t lanes[4];
+  _mm256_storeu_si256((__m256i *)lanes, sums);
+  total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(__SSE4_1__)
+  __m128i sums = _mm_setzero_si128();
+  for (; i + 4 <= table->size; i += 4) {
+    __m128i durations = _mm_loadu_si128((const __m128i *)(table->duration + i));
+    sums = _mm_add_epi64(sums, _mm_cvtepi32_epi64(durations));
+    sums = _mm_add_epi64(sums, _mm_cvtepi32_epi64(_mm_srli_si128(durations, 8)));
+  }
+
+  int64_t lanes[2];
+  _mm_storeu_si128((__m128i *)lanes, sums);
+  total = lanes[0] + lanes[1];
+#endif
+
+  for (; i < table->size; i++) {
+    total += table->duration[i];
+  }
+
+  return (double)total / table->size;
+}
+
+int matchTableLongestDuration(MatchTable table)
+{
+  if (NULL == table) {
+    return 0;
+  }
+
+  int i = 0;
+  int longest = 0;
+
+#if defined(__AVX2__)
+  __m256i maximum = _mm256_setzero_si256();
+  for (; i + 8 <= table->size; i += 8) {
+    maximum = _mm256_max_epi32(maximum,
+        _mm256_loadu_si256((const __m256i *)(table->duration + i)));
+  }
+
+  int32_t lanes[8];
+  _mm256_storeu_si256((__m256i *)lanes, maximum);
+  for (int lane = 0; lane < 8; lane++) {
+    longest = (lanes[lane] > longest) ? lanes[lane] : longest;
+  }
+#elif defined(__SSE4_1__)
+  __m128i maximum = _mm_setzero_si128();
+  for (; i + 4 <= table->size; i += 4) {
+    maximum = _mm_max_epi32(maximum,
+        _mm_loadu_si128((const __m128i *)(table->duration + i)));
+  }
+
+  int32_t lanes[4];
+  _mm_storeu_si128((__m128i *)lanes, maximum);
+  for (int lane = 0; lane < 4; lane++) {
+    longest = (lanes[lane] > longest) ? lanes[lane] : longest;
+  }
+#endif
+
+  for (; i < table->size; i++) {
+    longest = (table->duration[i] > longest) ? table->duration[i] : longest;
+  }
+
+  return longest;
+}
+
+void matchTableDestroy(MatchTable table)
+{
+  if (NULL == table) {
+    return;
+  }
+
+  free(table->first);
+  free(table);
+}
+
+static uint8_t matchTableOutcome(Match match)
+{
+  // the seat of the winner, as a removed participant leaves no player behind
+  switch (matchGetResult(match)) {
+  case FIRST_PLAYER:
+    return MATCH_TABLE_FIRST_WON;
+  case SECOND_PLAYER:
+    return MATCH_TABLE_SECOND_WON;
+  default:
+    return MATCH_TABLE_DRAW;
+  }
+}
+
+#if defined(__AVX2__)
+static int sumLanes(__m256i lanes)
+{
+  int32_t values[8];
+  _mm256_storeu_si256((__m256i *)values, lanes);
+
+  int sum = 0;
+  for (int lane = 0; lane < 8; lane++) {
+    sum += values[lane];
+  }
+  return sum;
+}
+#elif defined(__SSE4_1__)
+static int sumLanes(__m128i lanes)
+{
+  int32_t values[4];
+  _mm_storeu_si128((__m128i *)values, lanes);
+
+  return values[0] + values[1] + values[2] + values[3];
+}
+
+static __m128i loadOutcomes(const uint8_t *outcome)
+{
+  int32_t packed;
+  memcpy(&packed, outcome, sizeof(packed));
+  return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed));
+}
+#endif
@@ -0,0 +1,91 @@
+#ifndef _MATCHTABLE_H
+#define _MATCHTABLE_H
+
+#include <stdint.h>
+#include "matchvector.h"
+
+/**
+ * A columnar snapshot of Matches for aggregate queries. Every column is a
+ * contiguous array with one entry per match - the ids of the participants,
+ * the outcome and the duration - so an aggregate reads a few dense arrays
+ * instead of following the pointers of every Match.
+ * 
+ * The aggregates run as SIMD passes over the columns when the translation
+ * unit is compiled with AVX2 (-mavx2) or SSE4.1 (-msse4.1), and as scalar
+ * loops otherwise. The results are the same either way.
+ * 
+ * The table doesn't follow later changes to the matches (results changed by
+ * forfeits, removed matches), it should be built right before it is queried.
+ */
+typedef struct match_table_t *MatchTable;
+
+/** Outcome of a match, as stored in the table */
+typedef enum {
+  MATCH_TABLE_DRAW = 0,
+  MATCH_TABLE_FIRST_WON = 1,
+  MATCH_TABLE_SECOND_WON = 2
+} MatchTableOutcome;
+
+/** Results of a single player over the matches of a table */
+typedef struct match_table_results_t {
+  int wins;
+  int draws;
+  int losses;
+} MatchTableResults;
+
+/**
+ * Creates a table of the matches in the vector, in the order of the vector.
+ * 
+ * @param matches MatchVector of the matches to tabulate
+ * @return
+ *    NULL if NULL argument was provided or memory failure occured
+ *    new MatchTable otherwise
+ */
+MatchTable matchTableCreate(MatchVector matches);
+
+/**
+ * Gets the number of matches in the table.
+ * 
+ * @param table MatchTable in question
+ * @return number of matches (0 if table is NULL)
+ */
+int matchTableGetSize(MatchTable table);
+
+/**
+ * Counts the wins, draws and losses of a player over the matches of the
+ * table.
+ * 
+ * @param table MatchTable in question
+ * @param player_id id of the player
+ * @param results OUT results of the player, all 0 if the player didn't play
+ * @return
+ *    CHESS_NULL_ARGUMENT - provided argument was NULL
+ *    CHESS_SUCCESS - results were counted successfully
+ */
+ChessResult matchTableCountResults(MatchTable table, int player_id,
+                                   MatchTableResults *results);
+
+/**
+ * Gets the average duration of the matches in the table.
+ * 
+ * @param table MatchTable in question
+ * @return average duration, 0 if the table is empty or NULL
+ */
+double matchTableAverageDuration(MatchTable table);
+
+/**
+ * Gets the duration of the longest match in the table.
+ * 
+ * @param table MatchTable in question
+ * @return longest duration, 0 if the table is empty or NULL
+ */
+int matchTableLongestDuration(MatchTable table);
+
+/**
+ * Destroys the table. The matches it was created from are not affected.
+ * 
+ * @param table MatchTable to destroy
+ */
+void matchTableDestroy(MatchTable table);
+
+#endif // _MATCHTABLE_H
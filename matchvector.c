@@ -0,0 +1,186 @@
+#include <stdlib.h>
+#include <string.h>
+#include "matchvector.h"
+#include "match.h"
+
+/** Capacity of the array allocated on the first push */
+#define MATCH_VECTOR_INITIAL_CAPACITY 4
+
+struct match_vector_t
+{
+  Match *matches;
+  int size;
+  int capacity;
+  MatchHook hook;
+  Player owner;  // participant whose matches these are, for MATCH_HOOK_PLAYER
+};
+
+/**
+ * Stores a match at an index of the vector, and updates the match's position
+ * if the vector tracks it
+ * 
+ * @param vector MatchVector in question
+ * @param index index to store at, within the capacity of the vector
+ * @param match Match to store
+ */
+static void matchVectorPlace(MatchVector vector, int index, Match match);
+
+MatchVector matchVectorCreate(MatchHook hook, Player owner)
+{
+  MatchVector vector = (MatchVector)malloc(sizeof(*vector));
+
+  if (NULL == vector) {
+    return NULL;
+  }
+
+  vector->matches = NULL;
+  vector->size = 0;
+  vector->capacity = 0;
+  vector->hook = hook;
+  vector->owner = owner;
+  return vector;
+}
+
+MatchVector matchVectorCopy(MatchVector vector)
+{
+  if (NULL == vector) {
+    return NULL;
+  }
+
+  MatchVector copy = matchVectorCreate(MATCH_HOOK_NONE, NULL);
+  if ((NULL == copy) || (0 == vector->size)) {
+    return copy;
+  }
+
+  copy->matches = (Match *)malloc(vector->size * sizeof(*copy->matches));
+  if (NULL == copy->matches) {
+    free(copy);
+    return NULL;
+  }
+
+  memcpy(copy->matches, vector->matches, vector->size * sizeof(*copy->matches));
+  copy->size = vector->size;
+  copy->capacity = vector->size;
+  return copy;
+}
+
+int matchVectorGetSize(MatchVector vector)
+{
+  return (NULL == vector) ? 0 : vector->size;
+}
+
+Match matchVectorGet(MatchVector vector, int index)
+{
+  if ((NULL == vector) || (index < 0) || (index >= vector->size)) {
+    return NULL;
+  }
+
+  return vector->matches[index];
+}
+
+Match *matchVectorData(MatchVector vector)
+{
+  return (NULL == vector) ? NULL : vector->matches;
+}
+
+ChessResult matchVectorPush(MatchVector vector, Match match)
+{
+  if ((NULL == vector) || (NULL == match)) {
+    return CHESS_NULL_ARGUMENT;
+  }
+
+  // the capacity doubles, so pushes cost amortized O(1)
+  if (vector->size == vector->capacity) {
+    int capacity = (0 == vector->capacity) ? MATCH_VECTOR_INITIAL_CAPACITY :
+                                             2 * vector->capacity;
+    Match *matches = (Match *)realloc(vector->matches,
+                                      capacity * sizeof(*matches));
+    if (NULL == matches) {
+      return CHESS_OUT_OF_MEMORY;
+    }
+    vector->matches = matches;
+    vector->capacity = capacity;
+  }
+
+  matchVectorPlace(vector, vector->size++, match);
+  return CHESS_SUCCESS;
+}
+
+void matchVectorRemoveAt(MatchVector vector, int index)
+{
+  if ((NULL == vector) || (index < 0) || (index >= vector->size)) {
+    return;
+  }
+
+  int *position = matchGetHook(vector->matches[index], vector->hook,
+                               vector->owner);
+  if (NULL != position) {
+    *position = -1;
+  }
+
+  Match last = vector->matches[--vector->size];
+  if (index < vector->size) {
+    matchVectorPlace(vector, index, last);
+  }
+}
+
+bool matchVectorRemove(MatchVector vector, Match match)
+{
+  if ((NULL == vector) || (NULL == match)) {
+    return false;
+  }
+
+  // the match knows where it is, no scan is needed
+  int *position = matchGetHook(match, vector->hook, vector->owner);
+  if (NULL != position) {
+    if ((*position < 0) || (*position >= vector->size) ||
+        (vector->matches[*position] != match)) {
+      return false;
+    }
+    matchVectorRemoveAt(vector, *position);
+    return true;
+  }
+
+  for (int i = 0; i < vector->size; i++) {
+    if (vector->matches[i] == match) {
+      matchVectorRemoveAt(vector, i);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void matchVectorDestroy(MatchVector vector, bool destroy_matches)
+{
+  if (NULL == vector) {
+    return;
+  }
+
+  for (int i = 0; i < vector->size; i++) {
+    if (destroy_matches) {
+      matchDestroy(vector->matches[i]);
+      continue;
+    }
+
+    // the matches outlive the vector, and must no longer point into it
+    int *position = matchGetHook(vector->matches[i], vector->hook,
+                                 vector->owner);
+    if (NULL != position) {
+      *position = -1;
+    }
+  }
+
+  free(vector->matches);
+  free(vector);
+}
+
+static void matchVectorPlace(MatchVector vector, int index, Match match)
+{
+  vector->matches[index] = match;
+
+  int *position = matchGetHook(match, vector->hook, vector->owner);
+  if (NULL != position) {
+    *position = index;
+  }
+}
@@ -0,0 +1,118 @@
+#ifndef _MATCHVECTOR_H
+#define _MATCHVECTOR_H
+
+/**
+ * A growable array of Matches. The matches are stored contiguously, so
+ * scanning a vector reads sequential memory. Getting the size takes O(1),
+ * pushing takes amortized O(1) and removing by index takes O(1), as the last
+ * match is moved into the freed slot - the order of the matches is therefore
+ * not kept.
+ * 
+ * A vector created with a MatchHook other than MATCH_HOOK_NONE keeps every
+ * match informed of its position in the vector, so removing a match by
+ * instance takes O(1) as well. A match may be in a single vector per hook
+ * (and per participant, for MATCH_HOOK_PLAYER).
+ */
+typedef struct match_vector_t *MatchVector;
+
+#include <stdbool.h>
+#include "match.h"
+#include "player.h"
+
+/**
+ * Creates a new empty MatchVector. No array is allocated until the first
+ * match is pushed.
+ * 
+ * @param hook the vector's kind, MATCH_HOOK_NONE if the positions of its
+ *             matches shouldn't be tracked
+ * @param owner participant whose matches the vector holds, for
+ *              MATCH_HOOK_PLAYER. NULL otherwise
+ * @return 
+ *    NULL if memory failure occured
+ *    new MatchVector otherwise
+ */
+MatchVector matchVectorCreate(MatchHook hook, Player owner);
+
+/**
+ * Creates a copy of the vector, holding the same Match instances.
+ * The copy doesn't track the positions of its matches (MATCH_HOOK_NONE).
+ * 
+ * @param vector MatchVector to copy
+ * @return 
+ *    NULL if vector was NULL or memory failure occured
+ *    new MatchVector otherwise
+ */
+MatchVector matchVectorCopy(MatchVector vector);
+
+/**
+ * Returns the number of matches in the vector
+ * 
+ * @param vector MatchVector in question
+ * @return 
+ *    how many matches are in the vector, 0 if vector is NULL
+ */
+int matchVectorGetSize(MatchVector vector);
+
+/**
+ * Gets the match at the provided index
+ * 
+ * @param vector MatchVector in question
+ * @param index index of the match, between 0 and the size of the vector
+ * @return
+ *    Match at the index, NULL if vector is NULL or index is out of range
+ */
+Match matchVectorGet(MatchVector vector, int index);
+
+/**
+ * Gets the array the matches are stored in, for scanning them in order.
+ * Valid until the vector is changed.
+ * 
+ * @param vector MatchVector in question
+ * @return
+ *    Array of matchVectorGetSize(vector) matches (may be NULL if empty)
+ */
+Match *matchVectorData(MatchVector vector);
+
+/**
+ * Adds a match at the end of the vector
+ * 
+ * @param vector MatchVector to add to
+ * @param match Match to be added
+ * @return
+ *    CHESS_NULL_ARGUMENT - NULL argument was provided
+ *    CHESS_OUT_OF_MEMORY - the vector could not grow
+ *    CHESS_SUCCESS - match was added successfully.
+ */
+ChessResult matchVectorPush(MatchVector vector, Match match);
+
+/**
+ * Removes the match at the provided index, moving the last match into its
+ * place. Does nothing if the index is out of range.
+ * 
+ * @param vector MatchVector to remove from
+ * @param index index of the match to be removed
+ */
+void matchVectorRemoveAt(MatchVector vector, int index);
+
+/**
+ * Removes the provided match instance from the vector, as
+ * matchVectorRemoveAt. If match is not found in the vector, does nothing.
+ * Takes O(1) if the vector tracks the positions of its matches, otherwise
+ * the vector is scanned.
+ * 
+ * @param vector MatchVector to remove from
+ * @param match Match to be removed
+ * @return true match was found and removed
+ * @return false match was not in the vector, or NULL arguments were provided
+ */
+bool matchVectorRemove(MatchVector vector, Match match);
+
+/**
+ * Destroys the vector and (if instructed) the contained Matches
+ * 
+ * @param vector MatchVector to destroy
+ * @param destroy_matches if true, destroys the Matches in the vector as well
+ */
+void matchVectorDestroy(MatchVector vector, bool destroy_matches);
+
+#endif // _MATCHVECTOR_H
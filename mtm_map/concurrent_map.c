@@ -0,0 +1,326 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "concurrent_map.h"
+
+/**
+ * The concurrent map is an array of shards. Every key belongs to the shard
+ * picked by its hash, and every shard is an ordinary Map behind its own
+ * reader-writer lock. Operations on a single key lock a single shard, so the
+ * map scales with the number of shards instead of serializing on one mutex.
+ */
+typedef struct Shard_t {
+  pthread_rwlock_t lock;
+  Map map;
+} Shard;
+
+struct ConcurrentMap_t {
+  Shard *shards;
+  int shards_count;
+  hashMapKeyElement hash;
+  copyMapDataElements copyData;
+};
+
+/**
+ * Allocates a concurrent map with the given number of shards, none of which
+ * has a map yet.
+ *
+ * @param shards - number of shards
+ * @param copyData - data copy function, used by concurrentMapGet
+ * @param hash - key hash function
+ * @return
+ *    NULL if an allocation failed, the new map otherwise.
+ */
+static ConcurrentMap concurrentMapAllocate(int shards,
+                                           copyMapDataElements copyData,
+                                           hashMapKeyElement hash);
+
+/**
+ * Returns the shard a key belongs to.
+ *
+ * @param map - map in question
+ * @param key - key to be found
+ * @return
+ *    The shard of the key.
+ */
+static Shard *concurrentMapShard(ConcurrentMap map, MapKeyElement key);
+
+/**
+ * Hashes int keys of int keyed concurrent maps.
+ *
+ * @param key - pointer to int
+ * @return
+ *    Hash of the key.
+ */
+static unsigned int hashIntKey(MapKeyElement key);
+
+ConcurrentMap concurrentMapCreate(int shards,
+                                  copyMapDataElements copyDataElement,
+                                  copyMapKeyElements copyKeyElement,
+                                  freeMapDataElements freeDataElement,
+                                  freeMapKeyElements freeKeyElement,
+                                  compareMapKeyElements compareKeyElements,
+                                  hashMapKeyElement hashKeyElement)
+{
+  if ((shards <= 0) || (NULL == copyDataElement) || (NULL == copyKeyElement) ||
+      (NULL == freeDataElement) || (NULL == freeKeyElement) ||
+      (NULL == compareKeyElements) || (NULL == hashKeyElement)) {
+    return NULL;
+  }
+
+  ConcurrentMap map = concurrentMapAllocate(shards, copyDataElement,
+                                            hashKeyElement);
+  if (NULL == map) {
+    return NULL;
+  }
+
+  for (int i = 0; i < shards; ++i) {
+    map->shards[i].map = mapCreate(copyDataElement, copyKeyElement,
+                                   freeDataElement, freeKeyElement,
+                                   compareKeyElements);
+    if (NULL == map->shards[i].map) {
+      concurrentMapDestroy(map);
+      return NULL;
+    }
+  }
+
+  return map;
+}
+
+ConcurrentMap concurrentMapCreateIntKeyed(int shards,
+                                          copyMapDataElements copyDataElement,
+                                          freeMapDataElements freeDataElement)
+{
+  if ((shards <= 0) || (NULL == copyDataElement) || (NULL == freeDataElement)) {
+    return NULL;
+  }
+
+  ConcurrentMap map = concurrentMapAllocate(shards, copyDataElement,
+                                            hashIntKey);
+  if (NULL == map) {
+    return NULL;
+  }
+
+  for (int i = 0; i < shards; ++i) {
+    map->shards[i].map = mapCreateIntKeyed(copyDataElement, freeDataElement);
+    if (NULL == map->shards[i].map) {
+      concurrentMapDestroy(map);
+      return NULL;
+    }
+  }
+
+  return map;
+}
+
+void concurrentMapDestroy(ConcurrentMap map)
+{
+  if (NULL == map) {
+    return;
+  }
+
+  for (int i = 0; i < map->shards_count; ++i) {
+    mapDestroy(map->shards[i].map);
+    pthread_rwlock_destroy(&map->shards[i].lock);
+  }
+
+  free(map->shards);
+  free(map);
+}
+
+int concurrentMapGetSize(ConcurrentMap map)
+{
+  if (NULL == map) {
+    return -1;
+  }
+
+  int size = 0;
+  for (int i = 0; i < map->shards_count; ++i) {
+    pthread_rwlock_rdlock(&map->shards[i].lock);
+    size += mapGetSize(map->shards[i].map);
+    pthread_rwlock_unlock(&map->shards[i].lock);
+  }
+
+  return size;
+}
+
+bool concurrentMapContains(ConcurrentMap map, MapKeyElement element)
+{
+  if ((NULL == map) || (NULL == element)) {
+    return false;
+  }
+
+  Shard *shard = concurrentMapShard(map, element);
+  // lookups do not change the shard, so readers may share it
+  pthread_rwlock_rdlock(&shard->lock);
+  bool contains = mapContains(shard->map, element);
+  pthread_rwlock_unlock(&shard->lock);
+
+  return contains;
+}
+
+MapResult concurrentMapPut(ConcurrentMap map,
+                           MapKeyElement keyElement,
+                           MapDataElement dataElement)
+{
+  if ((NULL == map) || (NULL == keyElement) || (NULL == dataElement)) {
+    return MAP_NULL_ARGUMENT;
+  }
+
+  Shard *shard = concurrentMapShard(map, keyElement);
+  pthread_rwlock_wrlock(&shard->lock);
+  MapResult result = mapPut(shard->map, keyElement, dataElement);
+  pthread_rwlock_unlock(&shard->lock);
+
+  return result;
+}
+
+MapResult concurrentMapPutOwned(ConcurrentMap map,
+                                MapKeyElement keyElement,
+                                MapDataElement dataElement)
+{
+  if ((NULL == map) || (NULL == keyElement) || (NULL == dataElement)) {
+    return MAP_NULL_ARGUMENT;
+  }
+
+  Shard *shard = concurrentMapShard(map, keyElement);
+  pthread_rwlock_wrlock(&shard->lock);
+  MapResult result = mapPutOwned(shard->map, keyElement, dataElement);
+  pthread_rwlock_unlock(&shard->lock);
+
+  return result;
+}
+
+MapDataElement concurrentMapGet(ConcurrentMap map, MapKeyElement keyElement)
+{
+  if ((NULL == map) || (NULL == keyElement)) {
+    return NULL;
+  }
+
+  Shard *shard = concurrentMapShard(map, keyElement);
+  MapDataElement copy = NULL;
+
+  pthread_rwlock_rdlock(&shard->lock);
+  MapDataElement data = mapGet(shard->map, keyElement);
+  if (NULL != data) {
+    copy = map->copyData(data);
+  }
+  pthread_rwlock_unlock(&shard->lock);
+
+  return copy;
+}
+
+MapResult concurrentMapRemove(ConcurrentMap map, MapKeyElement keyElement)
+{
+  if ((NULL == map) || (NULL == keyElement)) {
+    return MAP_NULL_ARGUMENT;
+  }
+
+  Shard *shard = concurrentMapShard(map, keyElement);
+  pthread_rwlock_wrlock(&shard->lock);
+  MapResult result = mapRemove(shard->map, keyElement);
+  pthread_rwlock_unlock(&shard->lock);
+
+  return result;
+}
+
+MapDataElement concurrentMapTake(ConcurrentMap map, MapKeyElement keyElement)
+{
+  if ((NULL == map) || (NULL == keyElement)) {
+    return NULL;
+  }
+
+  Shard *shard = concurrentMapShard(map, keyElement);
+  pthread_rwlock_wrlock(&shard->lock);
+  MapDataElement data = mapTake(shard->map, keyElement);
+  pthread_rwlock_unlock(&shard->lock);
+
+  return data;
+}
+
+MapResult concurrentMapForEach(ConcurrentMap map,
+                               concurrentMapAction action,
+                               void *context)
+{
+  if ((NULL == map) || (NULL == action)) {
+    return MAP_NULL_ARGUMENT;
+  }
+
+  for (int i = 0; i < map->shards_count; ++i) {
+    bool proceed = true;
+
+    pthread_rwlock_rdlock(&map->shards[i].lock);
+    MAP_ITERATE(iterator, map->shards[i].map) {
+      proceed = action(mapIteratorKey(&iterator), mapIteratorData(&iterator),
+                       context);
+      if (!proceed) {
+        break;
+      }
+    }
+    pthread_rwlock_unlock(&map->shards[i].lock);
+
+    if (!proceed) {
+      break;
+    }
+  }
+
+  return MAP_SUCCESS;
+}
+
+MapResult concurrentMapClear(ConcurrentMap map)
+{
+  if (NULL == map) {
+    return MAP_NULL_ARGUMENT;
+  }
+
+  for (int i = 0; i < map->shards_count; ++i) {
+    pthread_rwlock_wrlock(&map->shards[i].lock);
+    mapClear(map->shards[i].map);
+    pthread_rwlock_unlock(&map->shards[i].lock);
+  }
+
+  return MAP_SUCCESS;
+}
+
+static ConcurrentMap concurrentMapAllocate(int shards,
+                                           copyMapDataElements copyData,
+                                           hashMapKeyElement hash)
+{
+  ConcurrentMap map = malloc(sizeof(*map));
+  if (NULL == map) {
+    return NULL;
+  }
+
+  map->shards = malloc(sizeof(*map->shards) * shards);
+  if (NULL == map->shards) {
+    free(map);
+    return NULL;
+  }
+
+  map->shards_count = 0;
+  for (int i = 0; i < shards; ++i) {
+    if (0 != pthread_rwlock_init(&map->shards[i].lock, NULL)) {
+      concurrentMapDestroy(map);
+      return NULL;
+    }
+    map->shards[i].map = NULL;
+    map->shards_count++;
+  }
+
+  map->hash = hash;
+  map->copyData = copyData;
+
+  return map;
+}
+
+static Shard *concurrentMapShard(ConcurrentMap map, MapKeyElement key)
+{
+  return &map->shards[map->hash(key) % (unsigned int) map->shards_count];
+}
+
+static unsigned int hashIntKey(MapKeyElement key)
+{
+  // multiplicative hashing, spreads consecutive ids over the shards
+  unsigned int hash = (unsigned int) *(int *) key * 2654435769u;
+  return hash ^ (hash >> 16);
+}
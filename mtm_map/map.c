@@ -1,14 +1,108 @@
 #include <stdlib.h>
-#ifndef NDEBUG
+#include <string.h>
 #include <assert.h>
-#endif  // NDEBUG
 #include "map.h"
 
-typedef struct node_t {
-  MapKeyElement key;
-  MapDataElement data;
-  struct node_t *next;
-  struct node_t *previous;
+/**
+ * The map is implemented as a B-tree. Every node stores its keys and data
+ * elements contiguously and in ascending key order, so a lookup performs a
+ * binary search per node and visits O(log n) nodes in total.
+ *
+ * MAP_MIN_DEGREE is the B-tree minimal degree: every node except the root
+ * holds between MAP_MIN_DEGREE - 1 and 2 * MAP_MIN_DEGREE - 1 keys.
+ */
+#define MAP_MIN_DEGREE 16
+#define MAP_NODE_KEYS (2 * MAP_MIN_DEGREE - 1)
+
+/**
+ * Maximal height of the tree. With a minimal fan-out of MAP_MIN_DEGREE this
+ * is far more than any map that fits in memory could need.
+ */
+#define MAP_MAX_DEPTH MAP_ITERATOR_MAX_DEPTH
+
+/**
+ * An int keyed map starts as a single sorted leaf, searched by binary search
+ * with inlined int comparisons. Its hash index is only built once it holds
+ * more than MAP_INDEX_MIN_KEYS keys, so small maps cost one node and no
+ * index, and stay within a few cache lines.
+ */
+#define MAP_INDEX_MIN_KEYS MAP_NODE_KEYS
+
+/** Initial number of slots in the hash index of an int keyed map */
+#define MAP_INDEX_INITIAL_CAPACITY 64
+
+/**
+ * Nodes and int keys are allocated from per map pools. A pool allocates its
+ * elements in chunks, starting small and doubling the chunk size up to a
+ * limit, so tiny maps stay tiny and large maps make few allocator calls.
+ */
+#define MAP_NODE_POOL_FIRST_CHUNK 1
+#define MAP_NODE_POOL_MAX_CHUNK 64
+#define MAP_KEY_POOL_FIRST_CHUNK 16
+#define MAP_KEY_POOL_MAX_CHUNK 4096
+
+/**
+ * A serialized map starts with MAP_STREAM_MAGIC, a format version byte and the
+ * number of pairs. Every pair follows as the length of the encoded key, the
+ * key, the length of the encoded data and the data. Numbers are 4 byte little
+ * endian.
+ */
+#define MAP_STREAM_MAGIC "MTMM"
+#define MAP_STREAM_VERSION 1
+#define MAP_STREAM_HEADER_SIZE 9
+#define MAP_STREAM_LENGTH_SIZE 4
+#define MAP_STREAM_MAX_ELEMENT (1 << 30)
+
+/** Initial size of the buffer elements are encoded into and decoded from */
+#define MAP_STREAM_BUFFER_SIZE 256
+
+/**
+ * Instrumentation, compiled in only when MAP_STATS is defined. MAP_STAT counts
+ * an event in the map's MapStats, and costs nothing otherwise.
+ * Lookups count as well, and readers may share a map (concurrent_map,
+ * read_mostly_map), so the counters are relaxed atomics: they never race, but
+ * are not ordered with anything else.
+ */
+#ifdef MAP_STATS
+#define MAP_STAT_ADD(map, counter, amount) \
+  ((void)__atomic_fetch_add(&(map)->stats.counter, (amount), __ATOMIC_RELAXED))
+#define MAP_STAT_LOAD(map, counter) \
+  __atomic_load_n(&(map)->stats.counter, __ATOMIC_RELAXED)
+#define MAP_STAT_CLEAR(map, counter) \
+  __atomic_store_n(&(map)->stats.counter, 0, __ATOMIC_RELAXED)
+#else
+#define MAP_STAT_ADD(map, counter, amount) ((void)0)
+#endif
+#define MAP_STAT(map, counter) MAP_STAT_ADD(map, counter, 1)
+
+/** Header of a chunk of pool elements, the elements follow it in memory */
+typedef struct pool_chunk_t {
+  struct pool_chunk_t *next;
+} *PoolChunk;
+
+typedef struct pool_t {
+  size_t element_size;
+  int chunk_capacity;      // elements in the next chunk to be allocated
+  int first_chunk_capacity;
+  int max_chunk_capacity;
+  PoolChunk chunks;
+  char *unused;            // first never used element of the newest chunk
+  int unused_count;
+  void *free_list;         // freed elements, linked through their first word
+} Pool;
+
+typedef struct index_slot_t {
+  int key;
+  MapDataElement data;  // NULL marks an empty slot
+} *IndexSlot;
+
+typedef struct MapNode_t {
+  int count;
+  int refs;  // owners of the node, more than one only in persistent maps
+  bool leaf;
+  MapKeyElement keys[MAP_NODE_KEYS];
+  MapDataElement data[MAP_NODE_KEYS];
+  struct MapNode_t *children[MAP_NODE_KEYS + 1];
 } *Node;
 
 struct Map_t {
@@ -18,46 +112,625 @@ struct Map_t {
   freeMapKeyElements freeKey;
   compareMapKeyElements compare;
 
-  Node top;
-  Node current;
+  Node root;
   int keys_count;
+
+  Pool nodes;
+  Pool keys;  // storage of the keys of int keyed maps
+
+  // nodes of persistent maps may be shared with their copies, so they are
+  // allocated on their own rather than from the pool of one map
+  bool persistent;
+
+  // keys are ints stored in the key pool, compared inline
+  bool int_keyed;
+
+  // hash index of int keyed maps, NULL for generic and small maps. Open
+  // addressing with linear probing, the capacity is a power of 2 and at most
+  // half full.
+  IndexSlot index;
+  int index_capacity;
+
+  MapIterator current;
+
+#ifdef MAP_STATS
+  MapStats stats;
+#endif
 };
 
 
 /**
- * Allocates a new dictionary node.
- * 
- * @param key - key element of new node. Assuming not NULL.
- * @param data - data element of new node. Assuming not NULL.
- * @param next - pointer to next node in the list, may be NULL
- * @param previous - pointer to previous node in the list, may be NULL.
+ * Initializes an empty pool.
+ *
+ * @param pool - pool to initialize
+ * @param element_size - size of the pool elements. Rounded up to hold at
+ *                       least a pointer, which links freed elements.
+ * @param first_chunk - number of elements in the first chunk
+ * @param max_chunk - maximal number of elements in a chunk
+ */
+static void poolInit(Pool *pool, size_t element_size, int first_chunk, int max_chunk);
+
+/**
+ * Allocates an element from the pool. Recycled elements are reused first.
+ *
+ * @param pool - pool to allocate from
+ * @return
+ *    Uninitialized element on success
+ *    NULL on memory allocation error
+ */
+static void *poolAlloc(Pool *pool);
+
+/**
+ * Returns an element to the pool for reuse.
+ *
+ * @param pool - pool the element was allocated from
+ * @param element - element to be recycled
+ */
+static void poolFree(Pool *pool, void *element);
+
+/**
+ * Frees all the chunks of a pool at once, and resets it to be empty, with
+ * the chunk size it was initialized with.
+ * All elements allocated from the pool are invalid afterwards.
+ *
+ * @param pool - pool to release
+ */
+static void poolRelease(Pool *pool);
+
+/**
+ * Allocates a new empty tree node from the map's node pool.
+ *
+ * @param map - map the node belongs to
+ * @param leaf - true if the node is a leaf.
  * @return
- *    Node populated with the arguments values on success
+ *    Empty Node on success
  *    NULL on memory allocation error
  */
-static Node newNode(MapKeyElement key, 
-                    MapDataElement data, 
-                    Node next,
-                    Node previous);
+static Node newNode(Map map, bool leaf);
+
+/**
+ * Frees a single node, without its elements or children.
+ *
+ * @param map - map the node belongs to
+ * @param node - node to be freed
+ */
+static void nodeFree(Map map, Node node);
+
+/**
+ * Frees the nodes of a subtree, without their elements.
+ *
+ * @param map - map the subtree belongs to
+ * @param node - root of the subtree
+ */
+static void nodeFreeStructure(Map map, Node node);
+
+/**
+ * Drops one reference to a node. The last reference frees the node, its
+ * elements and drops one reference to each of its children.
+ *
+ * @param map - map the node belongs to
+ * @param node - node to be released. May be NULL.
+ */
+static void nodeRelease(Map map, Node node);
+
+/**
+ * Creates a private copy of a shared node. Elements are copied with the copy
+ * functions of the map, children are shared with the original node.
+ *
+ * @param map - map the node belongs to
+ * @param node - node to be copied
+ * @return
+ *    The copy on success, NULL on memory allocation error
+ */
+static Node nodeClone(Map map, Node node);
+
+/**
+ * Makes sure the node stored in slot (a child pointer or the root pointer)
+ * is owned by that slot alone and may be changed. A shared node is replaced
+ * by a private copy of it.
+ *
+ * @param map - map the node belongs to
+ * @param slot - pointer to the node
+ * @return
+ *    The node that may be changed on success, NULL on memory allocation error
+ */
+static Node nodeWritable(Map map, Node *slot);
+
+/**
+ * Frees all keys and data elements of a subtree. The nodes themselves are
+ * left to be released with the map's node pool.
+ *
+ * @param map - map the node belongs to
+ * @param node - root of the subtree to be cleared. May be NULL.
+ */
+static void nodeClear(Map map, Node node);
+
+/**
+ * Copies a key into the map. Keys of int keyed maps are stored in the map's
+ * key pool, other keys are copied with the copy function of the map.
+ *
+ * @param map - map the key is copied into
+ * @param key - key to be copied
+ * @return
+ *    Copy of the key on success, NULL on memory allocation error
+ */
+static MapKeyElement mapKeyCopy(Map map, MapKeyElement key);
+
+/**
+ * Frees a key copied with mapKeyCopy.
+ *
+ * @param map - map the key belongs to
+ * @param key - key to be freed
+ */
+static void mapKeyFree(Map map, MapKeyElement key);
+
+/**
+ * Binary searches a node for the provided key.
+ *
+ * @param map - map the node belongs to
+ * @param node - node to be searched
+ * @param key - key to be found
+ * @param index - OUT the index of the first key in the node which is not
+ *                smaller than key (node->count if there is no such key)
+ * @return
+ *    true if the key at index is equal to key, false otherwise.
+ */
+static bool nodeSearch(Map map, Node node, MapKeyElement key, int *index);
+
+/**
+ * Creates a new empty map of the same kind and with the same functions as the
+ * provided map.
+ *
+ * @param map - map to take the kind and functions from
+ * @return
+ *    A new Map on success, NULL on memory allocation error.
+ */
+static Map mapCreateEmptyLike(Map map);
+
+/**
+ * Loads sorted arrays of keys and data elements into an empty map in linear
+ * time, by building the tree bottom up instead of inserting the elements one
+ * by one. The keys are assumed to be strictly ascending. Keys are always
+ * copied into the map, data elements are copied or adopted.
+ *
+ * @param map - empty map to load into
+ * @param keys - sorted keys
+ * @param data - data elements of the keys
+ * @param count - number of elements to load
+ * @param adopt_data - true if the map adopts the data elements as is
+ * @return
+ *    MAP_OUT_OF_MEMORY on memory allocation error, the map is left empty and
+ *                      adopted data elements still belong to the caller.
+ *    MAP_SUCCESS otherwise.
+ */
+static MapResult mapBuildSorted(Map map,
+                                MapKeyElement *keys,
+                                MapDataElement *data,
+                                int count,
+                                bool adopt_data);
+
+/**
+ * Builds a map from the union of two sorted maps, walking both in a single
+ * pass. Elements of first only, of second only and of both are merged as
+ * described in mapMerge. All arguments are assumed to be valid, except
+ * merge, which may be NULL.
+ *
+ * @param map - empty map to build, with the functions of first
+ * @param first - first map to merge
+ * @param second - second map to merge
+ * @param merge - merges the data elements of keys found in both maps
+ * @param replaced - OUT if not NULL, the data elements of first are adopted
+ *                   by map instead of copied, and those of keys found in
+ *                   both maps are stored here on success, to be freed by
+ *                   the caller. Room is assumed for as many elements as the
+ *                   smaller map holds.
+ * @param replaced_count - OUT number of data elements stored in replaced
+ * @return
+ *    MAP_OUT_OF_MEMORY on memory allocation error, map is left empty and
+ *                      first and second are unchanged.
+ *    MAP_SUCCESS otherwise.
+ */
+static MapResult mapBuildMerged(Map map,
+                                Map first,
+                                Map second,
+                                mergeMapDataElements merge,
+                                MapDataElement *replaced,
+                                int *replaced_count);
+
+/**
+ * Swaps the elements of two maps of the same kind, along with the storage
+ * they live in.
+ *
+ * @param map - first map
+ * @param other - second map
+ */
+static void mapSwapElements(Map map, Map other);
+
+/**
+ * freeMapDataElements which does nothing, for freeing a map whose data
+ * elements were handed over to another map.
+ */
+static void keepData(MapDataElement data);
+
+/**
+ * Builds the lowest tree that holds sorted keys and data elements. The
+ * elements are stored as they are, without being copied.
+ *
+ * @param map - map the tree belongs to
+ * @param keys - sorted keys
+ * @param data - data elements of the keys
+ * @param count - number of elements, at least 1
+ * @return
+ *    Root of the tree on success, NULL on memory allocation error.
+ */
+static Node mapBuildTree(Map map,
+                         MapKeyElement *keys,
+                         MapDataElement *data,
+                         int count);
+
+/**
+ * Builds a subtree of the given height from sorted keys and data elements,
+ * spreading the elements evenly between the children. The elements are stored
+ * as they are, without being copied.
+ *
+ * @param map - map the subtree belongs to
+ * @param keys - sorted keys of the subtree
+ * @param data - data elements of the keys
+ * @param count - number of elements in the subtree. Assumed to fit in a
+ *                subtree of the given height.
+ * @param height - height of the subtree, 1 for a leaf
+ * @param capacity - maximal number of keys in a subtree, by height
+ * @return
+ *    Root of the subtree on success, NULL on memory allocation error.
+ */
+static Node nodeBuild(Map map,
+                      MapKeyElement *keys,
+                      MapDataElement *data,
+                      int count,
+                      int height,
+                      const long *capacity);
 
 /**
- * Search a node in the map with the provided key. All arguments are
- * assumed to be valid.
- * 
+ * Search a key in the map. All arguments are assumed to be valid.
+ *
  * @param map - map to be searched
  * @param key - key to be found
+ * @param index - OUT index of the key in the returned node
+ * @return
+ *    Node holding the key if key was found in map, otherwise NULL.
+ */
+static Node mapFind(Map map, MapKeyElement key, int *index);
+
+/**
+ * Inserts a data element into the map, or replaces the data element of an
+ * existing key. The data element is adopted by the map as is, the key is
+ * copied if it is inserted. All arguments are assumed to be valid.
+ *
+ * @param map - map to insert to
+ * @param key - key of the data element
+ * @param data - data element to be adopted by the map
+ * @return
+ *    MAP_OUT_OF_MEMORY on memory allocation error, the data element is not
+ *                      adopted in this case.
+ *    MAP_SUCCESS otherwise.
+ */
+static MapResult mapInsert(Map map, MapKeyElement key, MapDataElement data);
+
+/**
+ * Finds the slot of a key in a single pass from the root, splitting every
+ * full node on the way, so a missing key can be placed in the returned leaf.
+ * A key already in a persistent map is found without copying its path, so
+ * the node holding it may be shared (see mapFindWritable).
+ * All arguments are assumed to be valid.
+ *
+ * @param map - map to search
+ * @param key - key to be found
+ * @param out_node - OUT node holding the key, or the leaf it belongs in
+ * @param out_index - OUT index of the key, or its insertion position
+ * @param found - OUT whether the key is already in the map
+ * @return
+ *    MAP_OUT_OF_MEMORY on memory allocation error, the map holds the same
+ *                      elements in this case.
+ *    MAP_SUCCESS otherwise.
+ */
+static MapResult mapFindSlot(Map map,
+                             MapKeyElement key,
+                             Node *out_node,
+                             int *out_index,
+                             bool *found);
+
+/**
+ * Places a new key in a leaf slot returned by mapFindSlot. The key is copied
+ * and the data element is adopted. All arguments are assumed to be valid.
+ *
+ * @param map - map to insert to
+ * @param leaf - leaf returned by mapFindSlot
+ * @param index - insertion position returned by mapFindSlot
+ * @param key - key of the data element
+ * @param data - data element to be adopted by the map
+ * @return
+ *    MAP_OUT_OF_MEMORY if the key could not be copied, the data element is
+ *                      not adopted in this case.
+ *    MAP_SUCCESS otherwise.
+ */
+static MapResult mapInsertAt(Map map,
+                             Node leaf,
+                             int index,
+                             MapKeyElement key,
+                             MapDataElement data);
+
+/**
+ * Frees the root of the map if it holds no keys. mapFindSlot creates an
+ * empty root in an empty map, which is left behind if the insertion fails
+ * after it.
+ *
+ * @param map - map whose root is checked
+ */
+static void mapDropEmptyRoot(Map map);
+
+/**
+ * Finds the node holding a key of a persistent map, copying the shared nodes
+ * on the path to it. The key is assumed to be in the map.
+ *
+ * @param map - persistent map to search
+ * @param key - key to be found
+ * @param index - OUT index of the key in the returned node
+ * @return
+ *    The node holding the key, which may be changed, NULL on memory
+ *    allocation error
+ */
+static Node mapFindWritable(Map map, MapKeyElement key, int *index);
+
+/**
+ * Detaches a key and its data element from the map, without freeing them.
+ * All arguments are assumed to be valid.
+ *
+ * @param map - map to detach from
+ * @param key - key to be detached
+ * @param out_key - OUT the key element stored in the map
+ * @param out_data - OUT the data element stored in the map
+ * @return
+ *    MAP_ITEM_DOES_NOT_EXIST if the key is not in the map
+ *    MAP_OUT_OF_MEMORY if a shared node could not be copied
+ *    MAP_SUCCESS if the key was found and detached
+ */
+static MapResult mapDetach(Map map,
+                      MapKeyElement key,
+                      MapKeyElement *out_key,
+                      MapDataElement *out_data);
+
+/**
+ * Splits the full child at the provided index of a non full node into two
+ * nodes, moving the median key up into the parent.
+ *
+ * @param map - map the nodes belong to
+ * @param parent - parent of the full node. Assumed not to be full.
+ * @param index - index of the full child in parent
+ * @return
+ *    true on success, false on memory allocation error.
+ */
+static bool nodeSplitChild(Map map, Node parent, int index);
+
+/**
+ * Merges the child at index + 1 and the key at index into the child at index.
+ * Both children are assumed to hold MAP_MIN_DEGREE - 1 keys.
+ *
+ * @param map - map the nodes belong to
+ * @param parent - parent of the merged nodes
+ * @param index - index of the left child to be merged
+ */
+static void nodeMergeChildren(Map map, Node parent, int index);
+
+/**
+ * Makes sure the child at index holds at least MAP_MIN_DEGREE keys, by
+ * borrowing a key from one of its siblings or by merging it with one of them.
+ *
+ * @param map - map the nodes belong to
+ * @param parent - parent of the child
+ * @param index - index of the child
+ * @return
+ *    Index of the child the key range is found in after the operation,
+ *    -1 on memory allocation error.
+ */
+static int nodeFillChild(Map map, Node parent, int index);
+
+/**
+ * Detaches a key and its data element from the subtree, without freeing them.
+ * The root of the subtree is assumed to hold at least MAP_MIN_DEGREE keys,
+ * unless it is the root of the tree.
+ *
+ * @param map - map the subtree belongs to
+ * @param node - root of the subtree
+ * @param key - key to be detached
+ * @param out_key - OUT the key element stored in the map
+ * @param out_data - OUT the data element stored in the map
+ * @return
+ *    MAP_ITEM_DOES_NOT_EXIST if the key is not in the subtree
+ *    MAP_OUT_OF_MEMORY if a shared node could not be copied
+ *    MAP_SUCCESS if the key was found and detached
+ */
+static MapResult nodeDetach(Map map,
+                       Node node,
+                       MapKeyElement key,
+                       MapKeyElement *out_key,
+                       MapDataElement *out_data);
+
+/**
+ * Extends the iterator path down to the leftmost key of a subtree.
+ * The iterator path is the path from the root to the current key. For every
+ * level but the last, path_index is the child the path descends into, on
+ * the last level it is the index of the current key.
+ *
+ * @param iterator - iterator in question
+ * @param node - root of the subtree. Must not be empty.
+ */
+static void iteratorDescendLeftmost(MapIterator *iterator, Node node);
+
+/**
+ * Advances the iterator to the next key in the map.
+ *
+ * @param iterator - iterator in question. Assumed to be valid.
+ */
+static void iteratorAdvance(MapIterator *iterator);
+
+/**
+ * Climbs up the iterator path while the index on its last level is past the
+ * keys of the node, so the iterator points to the next key of the map.
+ *
+ * @param iterator - iterator in question
+ */
+static void iteratorClimb(MapIterator *iterator);
+
+/**
+ * Ends the iteration if the iterator passed the end of its range.
+ *
+ * @param iterator - iterator in question
+ */
+static void iteratorCheckEnd(MapIterator *iterator);
+
+/**
+ * Copies an int key of an int keyed map.
+ *
+ * @param key - int key to be copied
+ * @return
+ *    Newly allocated copy of the key, NULL on memory allocation error
+ */
+static MapKeyElement copyIntKey(MapKeyElement key);
+
+/**
+ * Frees an int key of an int keyed map.
+ *
+ * @param key - int key to be freed
+ */
+static void freeIntKey(MapKeyElement key);
+
+/**
+ * Compares two int keys of an int keyed map.
+ *
+ * @param first - first int key
+ * @param second - second int key
+ * @return
+ *    A positive integer if first is greater, 0 if they're equal and
+ *    a negative integer if second is greater
+ */
+static int compareIntKeys(MapKeyElement first, MapKeyElement second);
+
+/**
+ * Finds the slot of a key in the hash index. The index is assumed to exist.
+ *
+ * @param map - int keyed map
+ * @param key - key to be found
+ * @return
+ *    The slot holding key if it is indexed, otherwise the empty slot where
+ *    key would be inserted.
+ */
+static IndexSlot mapIndexFind(Map map, int key);
+
+/**
+ * Makes sure the hash index has room for more keys, growing it if needed.
+ * Builds the index from the keys of the map once the map outgrows
+ * MAP_INDEX_MIN_KEYS, does nothing for smaller maps.
+ *
+ * @param map - int keyed map
+ * @param count - number of keys about to be added
  * @return
- *    Node if key was found in map, otherwise NULL.
+ *    true on success, false on memory allocation error.
+ */
+static bool mapIndexReserve(Map map, int count);
+
+/**
+ * Associates a key with its data element in the hash index. There is assumed
+ * to be room for the key (see mapIndexReserve).
+ *
+ * @param map - int keyed map
+ * @param key - indexed key
+ * @param data - data element stored in the map for key
+ */
+static void mapIndexPut(Map map, int key, MapDataElement data);
+
+/**
+ * Removes a key from the hash index. Keys following it in the probe sequence
+ * are shifted back, so no tombstones are left behind.
+ *
+ * @param map - int keyed map
+ * @param key - key to be removed
  */
-static Node mapFind(Map map, MapKeyElement key);
+static void mapIndexRemove(Map map, int key);
 
 /**
  * Resets the map iterator.
- * 
+ *
  * @param map - map in question
  */
 static void mapReset(Map map);
 
+/**
+ * Stores a number as MAP_STREAM_LENGTH_SIZE little endian bytes.
+ *
+ * @param bytes - where to store the number
+ * @param value - number to store, less than 2^32
+ */
+static void streamPutNumber(unsigned char *bytes, unsigned long value);
+
+/**
+ * Reads a number stored by streamPutNumber.
+ *
+ * @param bytes - where the number is stored
+ * @return
+ *    The number.
+ */
+static unsigned long streamGetNumber(const unsigned char *bytes);
+
+/**
+ * Makes sure a buffer holds at least the given number of bytes, growing it if
+ * needed.
+ *
+ * @param buffer - IN/OUT the buffer, may be NULL
+ * @param capacity - IN/OUT the size of the buffer
+ * @param needed - number of bytes needed
+ * @return
+ *    true on success, false on memory allocation error.
+ */
+static bool streamReserve(unsigned char **buffer, int *capacity, int needed);
+
+/**
+ * Appends an element to a serialized record, prefixed by its length.
+ *
+ * @param encode - encoding of the element
+ * @param element - element to be encoded
+ * @param record - IN/OUT the buffer holding the record
+ * @param capacity - IN/OUT the size of the buffer
+ * @param size - IN/OUT the size of the record
+ * @return
+ *    MAP_ERROR if the element could not be encoded
+ *    MAP_OUT_OF_MEMORY on memory allocation error
+ *    MAP_SUCCESS otherwise
+ */
+static MapResult streamAppendElement(encodeMapElement encode,
+                                     void *element,
+                                     unsigned char **record,
+                                     int *capacity,
+                                     int *size);
+
+/**
+ * Reads a length prefixed element from a stream and decodes it.
+ *
+ * @param stream - stream to read from
+ * @param decode - decoding of the element
+ * @param buffer - IN/OUT buffer to read the encoded element into
+ * @param capacity - IN/OUT the size of the buffer
+ * @param element - OUT the decoded element
+ * @return
+ *    MAP_ERROR if reading or decoding failed
+ *    MAP_OUT_OF_MEMORY on memory allocation error
+ *    MAP_SUCCESS otherwise
+ */
+static MapResult streamReadElement(FILE *stream,
+                                   decodeMapElement decode,
+                                   unsigned char **buffer,
+                                   int *capacity,
+                                   void **element);
+
 Map mapCreate(copyMapDataElements copy_data_elements_method,
               copyMapKeyElements copy_key_elements_method,
               freeMapDataElements free_data_elements_method,
@@ -69,7 +742,7 @@ Map mapCreate(copyMapDataElements copy_data_elements_method,
       (NULL == free_data_elements_method) ||
       (NULL == free_key_element_method) ||
       (NULL == compare_key_elements_method)) {
-    return NULL;  
+    return NULL;
   }
 
   Map map = (Map)malloc(sizeof(*map));
@@ -78,9 +751,18 @@ Map mapCreate(copyMapDataElements copy_data_elements_method,
     return NULL;
   }
 
-  map->top = NULL;
-  map->current = NULL;
+  map->root = NULL;
   map->keys_count = 0;
+  map->int_keyed = false;
+  map->index = NULL;
+  map->index_capacity = 0;
+  poolInit(&map->nodes, sizeof(struct MapNode_t),
+           MAP_NODE_POOL_FIRST_CHUNK, MAP_NODE_POOL_MAX_CHUNK);
+  poolInit(&map->keys, sizeof(int),
+           MAP_KEY_POOL_FIRST_CHUNK, MAP_KEY_POOL_MAX_CHUNK);
+  map->persistent = false;
+  mapReset(map);
+  mapResetStats(map);
 
   map->copyData = copy_data_elements_method;
   map->copyKey = copy_key_elements_method;
@@ -91,6 +773,43 @@ Map mapCreate(copyMapDataElements copy_data_elements_method,
   return map;
 }
 
+Map mapCreateIntKeyed(copyMapDataElements copy_data_elements_method,
+                      freeMapDataElements free_data_elements_method)
+{
+  Map map = mapCreate(copy_data_elements_method,
+                      copyIntKey,
+                      free_data_elements_method,
+                      freeIntKey,
+                      compareIntKeys);
+
+  if (NULL == map) {
+    return NULL;
+  }
+
+  map->int_keyed = true;
+  return map;
+}
+
+Map mapCreatePersistent(copyMapDataElements copy_data_elements_method,
+                        copyMapKeyElements copy_key_elements_method,
+                        freeMapDataElements free_data_elements_method,
+                        freeMapKeyElements free_key_element_method,
+                        compareMapKeyElements compare_key_elements_method)
+{
+  Map map = mapCreate(copy_data_elements_method,
+                      copy_key_elements_method,
+                      free_data_elements_method,
+                      free_key_element_method,
+                      compare_key_elements_method);
+
+  if (NULL == map) {
+    return NULL;
+  }
+
+  map->persistent = true;
+  return map;
+}
+
 void mapDestroy(Map map)
 {
   if (NULL == map) {
@@ -98,6 +817,7 @@ void mapDestroy(Map map)
   }
 
   mapClear(map);
+  free(map->index);
   free(map);
 }
 
@@ -105,28 +825,47 @@ Map mapCopy(Map map)
 {
   if (NULL == map) {
     return NULL;
-}
+  }
+
+  Map copy = mapCreateEmptyLike(map);
 
-  Map copy = mapCreate(map->copyData, map->copyKey, map->freeData, 
-                       map->freeKey, map->compare);
-  
   if (NULL == copy) {
     return NULL;
   }
 
-  MapKeyElement key = mapGetFirst(map);
-  MapDataElement data;
+  if (0 == map->keys_count) {
+    return copy;
+  }
 
-  while (NULL != key) {
-    data = mapGet(map, key);
-    if (MAP_SUCCESS != mapPut(copy, key, data)) {
-      break;
+  // the copy shares the whole tree, nodes are copied once either map
+  // changes them
+  if (map->persistent) {
+    copy->root = map->root;
+    copy->root->refs++;
+    copy->keys_count = map->keys_count;
+    return copy;
+  }
+
+  // the elements are already sorted, so the copy is built bottom up
+  MapKeyElement *keys = (MapKeyElement *)malloc(map->keys_count * sizeof(*keys));
+  MapDataElement *data = (MapDataElement *)malloc(map->keys_count * sizeof(*data));
+  MapResult result = MAP_OUT_OF_MEMORY;
+
+  if ((NULL != keys) && (NULL != data)) {
+    int count = 0;
+    MAP_ITERATE(iterator, map) {
+      keys[count] = mapIteratorKey(&iterator);
+      data[count] = mapIteratorData(&iterator);
+      count++;
     }
-    key = mapGetNext(map);
+    result = mapBuildSorted(copy, keys, data, count, false);
   }
 
+  free(keys);
+  free(data);
+
   // Had issues copying data to the new copy
-  if (NULL != key) {
+  if (MAP_SUCCESS != result) {
     mapDestroy(copy);
     return NULL;
   }
@@ -149,7 +888,13 @@ bool mapContains(Map map, MapKeyElement element)
     return false;
   }
 
-  if (NULL != mapFind(map, element)) {
+  MAP_STAT(map, finds);
+  if (NULL != map->index) {
+    return NULL != mapIndexFind(map, *(int *)element)->data;
+  }
+
+  int index;
+  if (NULL != mapFind(map, element, &index)) {
     return true;
   }
 
@@ -163,121 +908,486 @@ MapResult mapPut(Map map, MapKeyElement keyElement, MapDataElement dataElement)
   }
 
   MapDataElement data_copy = map->copyData(dataElement);
-  MapKeyElement key_copy = map->copyKey(keyElement);
-  
-  assert(NULL != data_copy);
-  assert(NULL != key_copy);
-
-  if ((NULL == data_copy) || (NULL == key_copy)) {
+  if (NULL == data_copy) {
     return MAP_OUT_OF_MEMORY;
   }
 
-  Node current_node;
-
-  // if key is already found, we need to update it
-  current_node = mapFind(map, key_copy);
-  if (NULL != current_node) {
-    MapDataElement old_data = current_node->data;
-    current_node->data = data_copy;
-    map->freeData(old_data);
-    return MAP_SUCCESS;
+  MapResult result = mapInsert(map, keyElement, data_copy);
+  if (MAP_SUCCESS != result) {
+    map->freeData(data_copy);
   }
 
-  current_node = map->top;
-  Node previous = NULL;
+  return result;
+}
 
-  while ((NULL != current_node) && 
-         (map->compare(key_copy, current_node->key)) > 0) {
-    previous = current_node;
-    current_node = current_node->next;
+MapResult mapPutOwned(Map map, MapKeyElement keyElement, MapDataElement dataElement)
+{
+  if ((NULL == map) || (NULL == keyElement) || (NULL == dataElement)) {
+    return MAP_NULL_ARGUMENT;
   }
 
-  Node new_node = newNode(key_copy, data_copy, current_node, previous);     
-  if (NULL == new_node) {                         
-    map->freeData(data_copy);                      
-    map->freeKey(key_copy);                       
-    return MAP_OUT_OF_MEMORY;         
+  return mapInsert(map, keyElement, dataElement);
+}
+
+MapResult mapPutBatch(Map map,
+                      MapKeyElement *keyElements,
+                      MapDataElement *dataElements,
+                      int count)
+{
+  if ((NULL == map) || (NULL == keyElements) || (NULL == dataElements)) {
+    return MAP_NULL_ARGUMENT;
   }
 
-  if (NULL != previous) {
-    previous->next = new_node;
+  if (count < 0) {
+    return MAP_ERROR;
   }
-  if (NULL != current_node) {
-    current_node->previous = new_node;
+
+  for (int i = 0; i < count; i++) {
+    if ((NULL == keyElements[i]) || (NULL == dataElements[i])) {
+      return MAP_NULL_ARGUMENT;
+    }
+    if (i > 0) {
+      MAP_STAT(map, comparisons);
+      if (map->compare(keyElements[i - 1], keyElements[i]) >= 0) {
+        return MAP_ERROR;
+      }
+    }
   }
 
-  map->keys_count++;
+  if (0 == map->keys_count) {
+    return mapBuildSorted(map, keyElements, dataElements, count, false);
+  }
 
-  // mapping was empty, put the new pair at the top
-  if (NULL == map->top) {
-    map->top = new_node;
+  // elements are merged into existing ones one by one
+  for (int i = 0; i < count; i++) {
+    MapResult result = mapPut(map, keyElements[i], dataElements[i]);
+    if (MAP_SUCCESS != result) {
+      return result;
+    }
   }
 
   return MAP_SUCCESS;
 }
 
-MapDataElement mapGet(Map map, MapKeyElement keyElement)
+MapResult mapTryInsert(Map map,
+                       MapKeyElement keyElement,
+                       createMapDataElement createDataElement,
+                       void *context,
+                       MapDataElement *dataElement)
 {
-  if ((NULL == map) || (NULL == keyElement)) {
-    return NULL;
+  if ((NULL == map) || (NULL == keyElement) || (NULL == createDataElement) ||
+      (NULL == dataElement)) {
+    return MAP_NULL_ARGUMENT;
   }
 
-  Node requested = mapFind(map, keyElement);
+  // hits on an indexed map are answered without touching the tree
+  if (NULL != map->index) {
+    *dataElement = mapIndexFind(map, *(int *)keyElement)->data;
+    if (NULL != *dataElement) {
+      MAP_STAT(map, finds);
+      return MAP_ITEM_ALREADY_EXISTS;
+    }
+  }
 
-  if (NULL == requested) {
-    return NULL;
+  Node node;
+  int index;
+  bool found;
+
+  MapResult result = mapFindSlot(map, keyElement, &node, &index, &found);
+  if (MAP_SUCCESS != result) {
+    return result;
   }
 
-  return requested->data;
-}
+  if (found) {
+    *dataElement = node->data[index];
+    return MAP_ITEM_ALREADY_EXISTS;
+  }
 
-MapResult mapRemove(Map map, MapKeyElement keyElement)
+  MapDataElement data = createDataElement(keyElement, context);
+  if (NULL == data) {
+    mapDropEmptyRoot(map);
+    return MAP_OUT_OF_MEMORY;
+  }
+
+  result = mapInsertAt(map, node, index, keyElement, data);
+  if (MAP_SUCCESS != result) {
+    map->freeData(data);
+    mapDropEmptyRoot(map);
+    return result;
+  }
+
+  *dataElement = data;
+
+  return MAP_SUCCESS;
+}
+
+MapDataElement mapGetOrInsert(Map map,
+                              MapKeyElement keyElement,
+                              createMapDataElement createDataElement,
+                              void *context)
 {
-  if ((NULL == map) || (NULL == keyElement)) {
+  MapDataElement data;
+
+  MapResult result = mapTryInsert(map, keyElement, createDataElement, context,
+                                  &data);
+  if ((MAP_SUCCESS != result) && (MAP_ITEM_ALREADY_EXISTS != result)) {
+    return NULL;
+  }
+
+  return data;
+}
+
+MapResult mapMerge(Map map, Map other, mergeMapDataElements mergeDataElements)
+{
+  if ((NULL == map) || (NULL == other)) {
     return MAP_NULL_ARGUMENT;
   }
 
-  Node requested = mapFind(map, keyElement);
+  if (0 == other->keys_count) {
+    return MAP_SUCCESS;
+  }
+
+  Map merged = mapCreateEmptyLike(map);
+  if (NULL == merged) {
+    return MAP_OUT_OF_MEMORY;
+  }
+
+  // data elements of map move to the merged tree as they are, unless they
+  // may be shared with copies of a persistent map
+  MapDataElement *replaced = NULL;
+  int replaced_count = 0;
+  if (!map->persistent) {
+    int smaller = (map->keys_count < other->keys_count) ? map->keys_count :
+                                                          other->keys_count;
+    replaced = (MapDataElement *)malloc((smaller + 1) * sizeof(*replaced));
+    if (NULL == replaced) {
+      mapDestroy(merged);
+      return MAP_OUT_OF_MEMORY;
+    }
+  }
+
+  MapResult result = mapBuildMerged(merged, map, other, mergeDataElements,
+                                    replaced, &replaced_count);
+  if (MAP_SUCCESS != result) {
+    free(replaced);
+    mapDestroy(merged);
+    return result;
+  }
+
+  // merged is left with the old elements of map, whose data elements now
+  // belong to map except for the replaced ones
+  mapSwapElements(map, merged);
+  if (NULL != replaced) {
+    for (int i = 0; i < replaced_count; i++) {
+      merged->freeData(replaced[i]);
+    }
+    merged->freeData = keepData;
+  }
+  free(replaced);
+  mapDestroy(merged);
+  mapReset(map);
+
+  return MAP_SUCCESS;
+}
+
+Map mapUnion(Map map, Map other, mergeMapDataElements mergeDataElements)
+{
+  if ((NULL == map) || (NULL == other)) {
+    return NULL;
+  }
+
+  Map merged = mapCreateEmptyLike(map);
+  if (NULL == merged) {
+    return NULL;
+  }
+
+  if (MAP_SUCCESS != mapBuildMerged(merged, map, other, mergeDataElements,
+                                    NULL, NULL)) {
+    mapDestroy(merged);
+    return NULL;
+  }
+
+  return merged;
+}
+
+MapDataElement mapGet(Map map, MapKeyElement keyElement)
+{
+  if ((NULL == map) || (NULL == keyElement)) {
+    return NULL;
+  }
+
+  MAP_STAT(map, finds);
+  if (NULL != map->index) {
+    return mapIndexFind(map, *(int *)keyElement)->data;
+  }
+
+  int index;
+  Node requested = mapFind(map, keyElement, &index);
+
   if (NULL == requested) {
-    return MAP_ITEM_DOES_NOT_EXIST;
+    return NULL;
   }
 
-  Node next_node = requested->next, prev_node = requested->previous;
-  next_node->previous = prev_node;
-  prev_node->next = next_node;
-  map->keys_count--;
+  return requested->data[index];
+}
+
+MapResult mapRemove(Map map, MapKeyElement keyElement)
+{
+  if ((NULL == map) || (NULL == keyElement)) {
+    return MAP_NULL_ARGUMENT;
+  }
+
+  MapKeyElement key;
+  MapDataElement data;
+
+  MapResult result = mapDetach(map, keyElement, &key, &data);
+  if (MAP_SUCCESS != result) {
+    return result;
+  }
+
+  map->freeData(data);
+  mapKeyFree(map, key);
 
-  map->freeData(requested->data);
-  map->freeKey(requested->key);
-  
-  free(requested);
   return MAP_SUCCESS;
 }
 
+MapResult mapRemoveIf(Map map, matchMapElements condition, void *context)
+{
+  if ((NULL == map) || (NULL == condition)) {
+    return MAP_NULL_ARGUMENT;
+  }
+
+  // a single walk splits the elements - the kept ones from the start of the
+  // arrays, the removed ones from their end. nothing is allocated until the
+  // first match, the elements before it are all kept
+  int count = map->keys_count;
+  MapKeyElement *keys = NULL;
+  MapDataElement *data = NULL;
+  int kept = 0, removed = 0, visited = 0;
+
+  MAP_ITERATE(iterator, map) {
+    MapKeyElement key = mapIteratorKey(&iterator);
+    MapDataElement element = mapIteratorData(&iterator);
+    bool matched = condition(key, element, context);
+
+    if (matched && (NULL == keys)) {
+      keys = (MapKeyElement *)malloc(count * sizeof(*keys));
+      data = (MapDataElement *)malloc(count * sizeof(*data));
+      if ((NULL == keys) || (NULL == data)) {
+        free(keys);
+        free(data);
+        return MAP_OUT_OF_MEMORY;
+      }
+      MapIterator earlier = mapIteratorBegin(map);
+      for (; kept < visited; kept++) {
+        keys[kept] = mapIteratorKey(&earlier);
+        data[kept] = mapIteratorData(&earlier);
+        mapIteratorNext(&earlier);
+      }
+    }
+
+    if (matched) {
+      removed++;
+      keys[count - removed] = key;
+      data[count - removed] = element;
+    } else if (NULL != keys) {
+      keys[kept] = key;
+      data[kept] = element;
+      kept++;
+    }
+    visited++;
+  }
+
+  if (0 == removed) {
+    return MAP_SUCCESS;
+  }
+
+  MapResult result = MAP_SUCCESS;
+  if (0 == kept) {
+    mapClear(map);
+  } else if (map->persistent) {
+    // elements of a persistent map may be shared with its copies, so the
+    // rebuilt tree gets copies of them, and the old tree is released
+    Map rebuilt = mapCreateEmptyLike(map);
+    result = (NULL == rebuilt) ? MAP_OUT_OF_MEMORY :
+             mapBuildSorted(rebuilt, keys, data, kept, false);
+
+    if (MAP_SUCCESS == result) {
+      mapSwapElements(map, rebuilt);
+      mapReset(map);
+    }
+    mapDestroy(rebuilt);
+  } else {
+    // the kept elements are moved into a tree built over them as they are,
+    // the old nodes are freed without their elements
+    Node root = mapBuildTree(map, keys, data, kept);
+    if (NULL == root) {
+      result = MAP_OUT_OF_MEMORY;
+    } else {
+      nodeFreeStructure(map, map->root);
+      map->root = root;
+      map->keys_count = kept;
+      for (int i = count - removed; i < count; i++) {
+        if (NULL != map->index) {
+          mapIndexRemove(map, *(int *)keys[i]);
+        }
+        map->freeData(data[i]);
+        mapKeyFree(map, keys[i]);
+      }
+      mapReset(map);
+    }
+  }
+
+  free(keys);
+  free(data);
+
+  return result;
+}
+
+MapDataElement mapTake(Map map, MapKeyElement keyElement)
+{
+  if ((NULL == map) || (NULL == keyElement)) {
+    return NULL;
+  }
+
+  MapKeyElement key;
+  MapDataElement data;
+
+  if (MAP_SUCCESS != mapDetach(map, keyElement, &key, &data)) {
+    return NULL;
+  }
+
+  mapKeyFree(map, key);
+
+  return data;
+}
+
 MapKeyElement mapGetFirst(Map map)
 {
   // bad map provided or mapping is empty
-  if (NULL == map || NULL == map->top) {
+  if (NULL == map || NULL == map->root || 0 == map->root->count) {
     return NULL;
   }
 
-  // next value to be enumerated is the second
-  map->current = map->top->next; 
+  map->current = mapIteratorBegin(map);
 
-  return map->copyKey(map->top->key);
+  return map->copyKey(mapIteratorKey(&map->current));
 }
 
 MapKeyElement mapGetNext(Map map)
 {
   // bad map or iterator has reached the end of the map
-  if ((NULL == map) || (NULL == map->current)) {
+  if ((NULL == map) || !mapIteratorValid(&map->current)) {
+    return NULL;
+  }
+
+  MAP_STAT(map, iterator_steps);
+  iteratorAdvance(&map->current);
+  if (!mapIteratorValid(&map->current)) {
+    return NULL;
+  }
+
+  return map->copyKey(mapIteratorKey(&map->current));
+}
+
+MapIterator mapIteratorBegin(Map map)
+{
+  MapIterator iterator;
+  iterator.depth = 0;
+  iterator.end = NULL;
+  iterator.compare = NULL;
+  iterator.map = map;
+
+  if ((NULL != map) && (NULL != map->root) && (map->root->count > 0)) {
+    iteratorDescendLeftmost(&iterator, map->root);
+  }
+
+  return iterator;
+}
+
+MapIterator mapLowerBound(Map map, MapKeyElement keyElement)
+{
+  MapIterator iterator = mapIteratorBegin(NULL);
+
+  if ((NULL == map) || (NULL == keyElement)) {
+    return iterator;
+  }
+  iterator.map = map;
+
+  // descend towards the key - on every level the path points to the first
+  // key not smaller than it, which is the next key after the subtree below
+  Node node = map->root;
+  while (NULL != node) {
+    int index;
+    bool found = nodeSearch(map, node, keyElement, &index);
+
+    iterator.path[iterator.depth] = node;
+    iterator.path_index[iterator.depth] = index;
+    iterator.depth++;
+
+    if (found || node->leaf) {
+      break;
+    }
+    node = node->children[index];
+  }
+
+  iteratorClimb(&iterator);
+  return iterator;
+}
+
+MapIterator mapGetRange(Map map,
+                        MapKeyElement lowKeyElement,
+                        MapKeyElement highKeyElement)
+{
+  if (NULL == highKeyElement) {
+    return mapIteratorBegin(NULL);
+  }
+
+  MapIterator iterator = mapLowerBound(map, lowKeyElement);
+
+  if (mapIteratorValid(&iterator)) {
+    iterator.end = highKeyElement;
+    iterator.compare = map->compare;
+    iteratorCheckEnd(&iterator);
+  }
+
+  return iterator;
+}
+
+bool mapIteratorValid(const MapIterator *iterator)
+{
+  return (NULL != iterator) && (iterator->depth > 0);
+}
+
+MapKeyElement mapIteratorKey(const MapIterator *iterator)
+{
+  if (!mapIteratorValid(iterator)) {
+    return NULL;
+  }
+
+  int top = iterator->depth - 1;
+  return iterator->path[top]->keys[iterator->path_index[top]];
+}
+
+MapDataElement mapIteratorData(const MapIterator *iterator)
+{
+  if (!mapIteratorValid(iterator)) {
     return NULL;
   }
 
-  MapKeyElement key = map->current->key;
-  map->current = map->current->next;
+  int top = iterator->depth - 1;
+  return iterator->path[top]->data[iterator->path_index[top]];
+}
+
+void mapIteratorNext(MapIterator *iterator)
+{
+  if (!mapIteratorValid(iterator)) {
+    return;
+  }
 
-  return map->copyKey(key);
+  MAP_STAT(iterator->map, iterator_steps);
+  iteratorAdvance(iterator);
+  iteratorCheckEnd(iterator);
 }
 
 MapResult mapClear(Map map)
@@ -286,61 +1396,1559 @@ MapResult mapClear(Map map)
     return MAP_NULL_ARGUMENT;
   }
 
-  Node current = map->top, next;
-
-  // destroy all nodes, keys and data elements
-  while (NULL != current) {
-    map->freeKey(current->key);
-    map->freeData(current->data);
-    next = current->next;
-    free(current);
-    current = next;
+  if (map->persistent) {
+    // nodes shared with copies of the map stay alive for them
+    nodeRelease(map, map->root);
+  } else {
+    // free all keys and data elements, then all nodes and keys storage at once
+    nodeClear(map, map->root);
+    poolRelease(&map->nodes);
+    poolRelease(&map->keys);
   }
 
   map->keys_count = 0;
-  map->top = NULL;
-  map->current = NULL;
+  map->root = NULL;
+  if (NULL != map->index) {
+    MAP_STAT(map, frees);
+  }
+  free(map->index);
+  map->index = NULL;
+  map->index_capacity = 0;
+  mapReset(map);
   return MAP_SUCCESS;
 }
 
-static Node mapFind(Map map, MapKeyElement key)
+MapResult mapGetStats(Map map, MapStats *stats)
 {
-  Node current_node = map->top;
+  if ((NULL == map) || (NULL == stats)) {
+    return MAP_NULL_ARGUMENT;
+  }
 
-  while (NULL != current_node) {
-    if (0 == map->compare(current_node->key, key)) {
-      return current_node;
+#ifdef MAP_STATS
+  stats->finds = MAP_STAT_LOAD(map, finds);
+  stats->nodes_visited = MAP_STAT_LOAD(map, nodes_visited);
+  stats->comparisons = MAP_STAT_LOAD(map, comparisons);
+  stats->index_probes = MAP_STAT_LOAD(map, index_probes);
+  stats->allocations = MAP_STAT_LOAD(map, allocations);
+  stats->frees = MAP_STAT_LOAD(map, frees);
+  stats->iterator_steps = MAP_STAT_LOAD(map, iterator_steps);
+#else
+  *stats = (MapStats){0};
+#endif
+  return MAP_SUCCESS;
+}
+
+MapResult mapResetStats(Map map)
+{
+  if (NULL == map) {
+    return MAP_NULL_ARGUMENT;
+  }
+
+#ifdef MAP_STATS
+  MAP_STAT_CLEAR(map, finds);
+  MAP_STAT_CLEAR(map, nodes_visited);
+  MAP_STAT_CLEAR(map, comparisons);
+  MAP_STAT_CLEAR(map, index_probes);
+  MAP_STAT_CLEAR(map, allocations);
+  MAP_STAT_CLEAR(map, frees);
+  MAP_STAT_CLEAR(map, iterator_steps);
+#endif
+  return MAP_SUCCESS;
+}
+
+MapResult mapSerialize(Map map,
+                       FILE *stream,
+                       encodeMapElement encodeKey,
+                       encodeMapElement encodeData)
+{
+  if ((NULL == map) || (NULL == stream) ||
+      (NULL == encodeKey) || (NULL == encodeData)) {
+    return MAP_NULL_ARGUMENT;
+  }
+
+  unsigned char header[MAP_STREAM_HEADER_SIZE];
+  memcpy(header, MAP_STREAM_MAGIC, strlen(MAP_STREAM_MAGIC));
+  header[strlen(MAP_STREAM_MAGIC)] = MAP_STREAM_VERSION;
+  streamPutNumber(header + strlen(MAP_STREAM_MAGIC) + 1,
+                  (unsigned long)map->keys_count);
+  if (1 != fwrite(header, sizeof(header), 1, stream)) {
+    return MAP_ERROR;
+  }
+
+  unsigned char *record = NULL;
+  int capacity = 0;
+  MapResult result = MAP_SUCCESS;
+
+  // every pair is encoded into one record, written with a single call
+  MAP_ITERATE(iterator, map) {
+    int size = 0;
+
+    result = streamAppendElement(encodeKey, mapIteratorKey(&iterator),
+                                 &record, &capacity, &size);
+    if (MAP_SUCCESS == result) {
+      result = streamAppendElement(encodeData, mapIteratorData(&iterator),
+                                   &record, &capacity, &size);
+    }
+    if ((MAP_SUCCESS == result) && (1 != fwrite(record, size, 1, stream))) {
+      result = MAP_ERROR;
+    }
+    if (MAP_SUCCESS != result) {
+      break;
     }
-    current_node = current_node->next;
   }
 
-  return NULL;
+  free(record);
+  return result;
 }
 
-static Node newNode(MapKeyElement key, 
-                    MapDataElement data, 
-                    Node next,
-                    Node previous)
+MapResult mapDeserialize(Map map,
+                         FILE *stream,
+                         decodeMapElement decodeKey,
+                         decodeMapElement decodeData)
 {
-  Node new_node = (Node)malloc(sizeof(struct node_t));
+  if ((NULL == map) || (NULL == stream) ||
+      (NULL == decodeKey) || (NULL == decodeData)) {
+    return MAP_NULL_ARGUMENT;
+  }
 
-  if (NULL == new_node) {
+  mapClear(map);
+
+  unsigned char header[MAP_STREAM_HEADER_SIZE];
+  size_t magic_size = strlen(MAP_STREAM_MAGIC);
+  if ((1 != fread(header, sizeof(header), 1, stream)) ||
+      (0 != memcmp(header, MAP_STREAM_MAGIC, magic_size)) ||
+      (MAP_STREAM_VERSION != header[magic_size])) {
+    return MAP_ERROR;
+  }
+
+  unsigned long count = streamGetNumber(header + magic_size + 1);
+  MapKeyElement *keys = NULL;
+  MapDataElement *data = NULL;
+  int capacity = 0, decoded = 0;
+  unsigned char *buffer = NULL;
+  int buffer_capacity = 0;
+  MapResult result = (count > MAP_STREAM_MAX_ELEMENT) ? MAP_ERROR :
+                                                        MAP_SUCCESS;
+
+  // the arrays grow as pairs are read, rather than trusting the count
+  while ((MAP_SUCCESS == result) && ((unsigned long)decoded < count)) {
+    if (decoded == capacity) {
+      int new_capacity = (0 == capacity) ? MAP_STREAM_BUFFER_SIZE : 2 * capacity;
+      size_t keys_size = new_capacity * sizeof(*keys);
+      size_t data_size = new_capacity * sizeof(*data);
+
+      MapKeyElement *new_keys = (MapKeyElement *)realloc(keys, keys_size);
+      if (NULL != new_keys) {
+        keys = new_keys;
+      }
+      MapDataElement *new_data = (MapDataElement *)realloc(data, data_size);
+      if (NULL != new_data) {
+        data = new_data;
+      }
+      if ((NULL == new_keys) || (NULL == new_data)) {
+        result = MAP_OUT_OF_MEMORY;
+        break;
+      }
+      capacity = new_capacity;
+    }
+
+    void *key = NULL, *element = NULL;
+    result = streamReadElement(stream, decodeKey, &buffer, &buffer_capacity,
+                               &key);
+    if (MAP_SUCCESS == result) {
+      result = streamReadElement(stream, decodeData, &buffer, &buffer_capacity,
+                                 &element);
+    }
+    if ((MAP_SUCCESS == result) && (decoded > 0)) {
+      MAP_STAT(map, comparisons);
+      if (map->compare(keys[decoded - 1], key) >= 0) {
+        result = MAP_ERROR;
+      }
+    }
+    if (MAP_SUCCESS != result) {
+      if (NULL != key) {
+        map->freeKey(key);
+      }
+      if (NULL != element) {
+        map->freeData(element);
+      }
+      break;
+    }
+
+    keys[decoded] = key;
+    data[decoded] = element;
+    decoded++;
+  }
+  free(buffer);
+
+  if (MAP_SUCCESS == result) {
+    result = mapBuildSorted(map, keys, data, decoded, true);
+  }
+
+  // the map holds copies of the keys, and the data elements on success
+  for (int i = 0; i < decoded; i++) {
+    map->freeKey(keys[i]);
+    if (MAP_SUCCESS != result) {
+      map->freeData(data[i]);
+    }
+  }
+  free(keys);
+  free(data);
+
+  return result;
+}
+
+int mapEncodeInt(void *element, unsigned char *buffer, int size)
+{
+  if (size >= MAP_STREAM_LENGTH_SIZE) {
+    streamPutNumber(buffer, (unsigned long)(unsigned int)*(int *)element);
+  }
+
+  return MAP_STREAM_LENGTH_SIZE;
+}
+
+void *mapDecodeInt(const unsigned char *buffer, int size)
+{
+  if (MAP_STREAM_LENGTH_SIZE != size) {
     return NULL;
   }
 
-  new_node->key = key;
-  new_node->data = data;
-  new_node->next = next;
-  new_node->previous = previous;
+  int *element = (int *)malloc(sizeof(*element));
+  if (NULL == element) {
+    return NULL;
+  }
 
-  return new_node;
+  // back from two's complement without relying on unsigned to int conversion
+  long long value = (long long)streamGetNumber(buffer);
+  *element = (int)((value > 0x7fffffffLL) ? value - 0x100000000LL : value);
+  return element;
 }
 
-static void mapReset(Map map)
+static MapResult mapInsert(Map map, MapKeyElement key, MapDataElement data)
 {
-  if (NULL == map) {
-    return;
+  Node node;
+  int index;
+  bool found;
+
+  MapResult result = mapFindSlot(map, key, &node, &index, &found);
+  if (MAP_SUCCESS != result) {
+    return result;
+  }
+
+  if (!found) {
+    result = mapInsertAt(map, node, index, key, data);
+    if (MAP_SUCCESS != result) {
+      mapDropEmptyRoot(map);
+    }
+    return result;
+  }
+
+  // if key is already found, we need to update it
+  if (map->persistent) {
+    node = mapFindWritable(map, key, &index);
+    if (NULL == node) {
+      return MAP_OUT_OF_MEMORY;
+    }
+  }
+  MapDataElement old_data = node->data[index];
+  node->data[index] = data;
+  map->freeData(old_data);
+  if (NULL != map->index) {
+    mapIndexPut(map, *(int *)key, data);
+  }
+
+  return MAP_SUCCESS;
+}
+
+static MapResult mapFindSlot(Map map,
+                             MapKeyElement key,
+                             Node *out_node,
+                             int *out_index,
+                             bool *found)
+{
+  MAP_STAT(map, finds);
+
+  // a key already in a persistent map must not copy its path, only an
+  // insertion does
+  if (map->persistent) {
+    Node node = mapFind(map, key, out_index);
+    if (NULL != node) {
+      *out_node = node;
+      *found = true;
+      return MAP_SUCCESS;
+    }
+  }
+
+  // index must have room before the tree changes, so it can't fail later
+  if (map->int_keyed && !mapIndexReserve(map, 1)) {
+    return MAP_OUT_OF_MEMORY;
+  }
+
+  if (NULL == map->root) {
+    map->root = newNode(map, true);
+    if (NULL == map->root) {
+      return MAP_OUT_OF_MEMORY;
+    }
+  } else if (NULL == nodeWritable(map, &map->root)) {
+    return MAP_OUT_OF_MEMORY;
+  }
+
+  // full root is split in advance, so the tree grows from the top
+  if (MAP_NODE_KEYS == map->root->count) {
+    Node new_root = newNode(map, false);
+    if (NULL == new_root) {
+      return MAP_OUT_OF_MEMORY;
+    }
+    new_root->children[0] = map->root;
+    if (!nodeSplitChild(map, new_root, 0)) {
+      nodeFree(map, new_root);
+      return MAP_OUT_OF_MEMORY;
+    }
+    map->root = new_root;
+  }
+
+  // single pass from the root - every full node on the way is split before
+  // it is entered, so there is always room for the new key in the leaf.
+  // nodes on the way are made writable, which copies the path in a
+  // persistent map
+  Node current_node = map->root;
+  int index;
+
+  while (true) {
+    *found = nodeSearch(map, current_node, key, &index);
+    if (*found || current_node->leaf) {
+      break;
+    }
+
+    if (NULL == nodeWritable(map, &current_node->children[index])) {
+      return MAP_OUT_OF_MEMORY;
+    }
+
+    if (MAP_NODE_KEYS == current_node->children[index]->count) {
+      if (!nodeSplitChild(map, current_node, index)) {
+        return MAP_OUT_OF_MEMORY;
+      }
+      // the median moved up, decide on which side of it the key belongs
+      MAP_STAT(map, comparisons);
+      int compare = map->compare(key, current_node->keys[index]);
+      if (0 == compare) {
+        continue;
+      }
+      if (compare > 0) {
+        index++;
+      }
+    }
+
+    current_node = current_node->children[index];
   }
 
-  map->current = map->top;
-}
\ No newline at end of file
+  *out_node = current_node;
+  *out_index = index;
+
+  return MAP_SUCCESS;
+}
+
+static MapResult mapInsertAt(Map map,
+                             Node leaf,
+                             int index,
+                             MapKeyElement key,
+                             MapDataElement data)
+{
+  MapKeyElement key_copy = mapKeyCopy(map, key);
+  if (NULL == key_copy) {
+    return MAP_OUT_OF_MEMORY;
+  }
+
+  for (int i = leaf->count; i > index; i--) {
+    leaf->keys[i] = leaf->keys[i - 1];
+    leaf->data[i] = leaf->data[i - 1];
+  }
+  leaf->keys[index] = key_copy;
+  leaf->data[index] = data;
+  leaf->count++;
+  map->keys_count++;
+
+  if (NULL != map->index) {
+    mapIndexPut(map, *(int *)key, data);
+  }
+
+  return MAP_SUCCESS;
+}
+
+static void mapDropEmptyRoot(Map map)
+{
+  if ((NULL != map->root) && (0 == map->root->count)) {
+    nodeFree(map, map->root);
+    map->root = NULL;
+  }
+}
+
+static Node mapFindWritable(Map map, MapKeyElement key, int *index)
+{
+  if (NULL == nodeWritable(map, &map->root)) {
+    return NULL;
+  }
+
+  // the key is in the map, so the descent stops before passing a leaf
+  Node current_node = map->root;
+  while (!nodeSearch(map, current_node, key, index)) {
+    current_node = nodeWritable(map, &current_node->children[*index]);
+    if (NULL == current_node) {
+      return NULL;
+    }
+  }
+
+  return current_node;
+}
+
+static MapResult mapDetach(Map map,
+                           MapKeyElement key,
+                           MapKeyElement *out_key,
+                           MapDataElement *out_data)
+{
+  MAP_STAT(map, finds);
+  if (NULL == map->root) {
+    return MAP_ITEM_DOES_NOT_EXIST;
+  }
+
+  // a missing key must not copy the path of a persistent map
+  int index;
+  if (map->persistent && (NULL == mapFind(map, key, &index))) {
+    return MAP_ITEM_DOES_NOT_EXIST;
+  }
+
+  if (NULL == nodeWritable(map, &map->root)) {
+    return MAP_OUT_OF_MEMORY;
+  }
+
+  MapResult result = nodeDetach(map, map->root, key, out_key, out_data);
+
+  // root was emptied by a merge or by removing its last key
+  if (0 == map->root->count) {
+    Node old_root = map->root;
+    map->root = old_root->leaf ? NULL : old_root->children[0];
+    nodeFree(map, old_root);
+  }
+
+  mapReset(map);
+  if (MAP_SUCCESS != result) {
+    return result;
+  }
+
+  map->keys_count--;
+  if (NULL != map->index) {
+    mapIndexRemove(map, *(int *)*out_key);
+  }
+
+  return MAP_SUCCESS;
+}
+
+static Map mapCreateEmptyLike(Map map)
+{
+  if (map->int_keyed) {
+    return mapCreateIntKeyed(map->copyData, map->freeData);
+  }
+
+  if (map->persistent) {
+    return mapCreatePersistent(map->copyData, map->copyKey, map->freeData,
+                               map->freeKey, map->compare);
+  }
+
+  return mapCreate(map->copyData, map->copyKey, map->freeData,
+                   map->freeKey, map->compare);
+}
+
+static MapResult mapBuildSorted(Map map,
+                                MapKeyElement *keys,
+                                MapDataElement *data,
+                                int count,
+                                bool adopt_data)
+{
+  assert(0 == map->keys_count);
+
+  if (0 == count) {
+    return MAP_SUCCESS;
+  }
+
+  if (map->int_keyed && !mapIndexReserve(map, count)) {
+    return MAP_OUT_OF_MEMORY;
+  }
+
+  // the tree is built over the caller's elements, which are then replaced
+  // by copies in order - on failure the copies made so far are freed
+  map->root = mapBuildTree(map, keys, data, count);
+  if (NULL == map->root) {
+    return MAP_OUT_OF_MEMORY;
+  }
+
+  int copied = 0;
+  MapIterator iterator = mapIteratorBegin(map);
+
+  while (mapIteratorValid(&iterator)) {
+    Node node = iterator.path[iterator.depth - 1];
+    int index = iterator.path_index[iterator.depth - 1];
+
+    MapKeyElement key_copy = mapKeyCopy(map, node->keys[index]);
+    MapDataElement data_copy = adopt_data ? node->data[index] :
+                                            map->copyData(node->data[index]);
+    if ((NULL == key_copy) || (NULL == data_copy)) {
+      if (NULL != key_copy) {
+        mapKeyFree(map, key_copy);
+      }
+      if (!adopt_data && (NULL != data_copy)) {
+        map->freeData(data_copy);
+      }
+      break;
+    }
+
+    node->keys[index] = key_copy;
+    node->data[index] = data_copy;
+    copied++;
+    mapIteratorNext(&iterator);
+  }
+
+  if (copied < count) {
+    MapIterator undo = mapIteratorBegin(map);
+    for (int i = 0; i < copied; i++) {
+      mapKeyFree(map, mapIteratorKey(&undo));
+      if (!adopt_data) {
+        map->freeData(mapIteratorData(&undo));
+      }
+      mapIteratorNext(&undo);
+    }
+
+    nodeFreeStructure(map, map->root);
+    map->root = NULL;
+    return MAP_OUT_OF_MEMORY;
+  }
+
+  map->keys_count = count;
+  if (NULL != map->index) {
+    MAP_ITERATE(indexed, map) {
+      mapIndexPut(map, *(int *)mapIteratorKey(&indexed), mapIteratorData(&indexed));
+    }
+  }
+
+  mapReset(map);
+  return MAP_SUCCESS;
+}
+
+static MapResult mapBuildMerged(Map map,
+                                Map first,
+                                Map second,
+                                mergeMapDataElements merge,
+                                MapDataElement *replaced,
+                                int *replaced_count)
+{
+  int capacity = first->keys_count + second->keys_count;
+  if (0 == capacity) {
+    return MAP_SUCCESS;
+  }
+
+  MapKeyElement *keys = (MapKeyElement *)malloc(capacity * sizeof(*keys));
+  MapDataElement *data = (MapDataElement *)malloc(capacity * sizeof(*data));
+  bool *adopted = (bool *)malloc(capacity * sizeof(*adopted));
+  MapResult result = MAP_OUT_OF_MEMORY;
+  int count = 0, conflicts = 0;
+
+  if ((NULL != keys) && (NULL != data) && (NULL != adopted)) {
+    MapIterator first_iterator = mapIteratorBegin(first);
+    MapIterator second_iterator = mapIteratorBegin(second);
+    result = MAP_SUCCESS;
+
+    // both maps are sorted, so the smaller of the two current keys is next
+    while (mapIteratorValid(&first_iterator) ||
+           mapIteratorValid(&second_iterator)) {
+      int order = 1;
+      if (!mapIteratorValid(&second_iterator)) {
+        order = -1;
+      } else if (mapIteratorValid(&first_iterator)) {
+        MAP_STAT(map, comparisons);
+        order = map->compare(mapIteratorKey(&first_iterator),
+                             mapIteratorKey(&second_iterator));
+      }
+
+      MapDataElement element;
+      adopted[count] = false;
+      if (order < 0) {
+        keys[count] = mapIteratorKey(&first_iterator);
+        adopted[count] = (NULL != replaced);
+        element = adopted[count] ? mapIteratorData(&first_iterator) :
+                                   map->copyData(mapIteratorData(&first_iterator));
+        mapIteratorNext(&first_iterator);
+      } else if (order > 0) {
+        keys[count] = mapIteratorKey(&second_iterator);
+        element = map->copyData(mapIteratorData(&second_iterator));
+        mapIteratorNext(&second_iterator);
+      } else {
+        keys[count] = mapIteratorKey(&first_iterator);
+        element = (NULL == merge) ?
+                  map->copyData(mapIteratorData(&second_iterator)) :
+                  merge(keys[count], mapIteratorData(&first_iterator),
+                        mapIteratorData(&second_iterator));
+        if ((NULL != element) && (NULL != replaced)) {
+          replaced[conflicts++] = mapIteratorData(&first_iterator);
+        }
+        mapIteratorNext(&first_iterator);
+        mapIteratorNext(&second_iterator);
+      }
+
+      if (NULL == element) {
+        result = MAP_OUT_OF_MEMORY;
+        break;
+      }
+      data[count++] = element;
+    }
+  }
+
+  if (MAP_SUCCESS == result) {
+    result = mapBuildSorted(map, keys, data, count, true);
+  }
+
+  // on failure the elements made for the merged map are freed, and the
+  // adopted ones stay with first
+  if (MAP_SUCCESS != result) {
+    for (int i = 0; i < count; i++) {
+      if (!adopted[i]) {
+        map->freeData(data[i]);
+      }
+    }
+    conflicts = 0;
+  }
+
+  if (NULL != replaced_count) {
+    *replaced_count = conflicts;
+  }
+
+  free(keys);
+  free(data);
+  free(adopted);
+
+  return result;
+}
+
+static void mapSwapElements(Map map, Map other)
+{
+  struct Map_t temp = *map;
+
+  map->root = other->root;
+  map->keys_count = other->keys_count;
+  map->nodes = other->nodes;
+  map->keys = other->keys;
+  map->index = other->index;
+  map->index_capacity = other->index_capacity;
+
+  other->root = temp.root;
+  other->keys_count = temp.keys_count;
+  other->nodes = temp.nodes;
+  other->keys = temp.keys;
+  other->index = temp.index;
+  other->index_capacity = temp.index_capacity;
+}
+
+static void keepData(MapDataElement data)
+{
+  (void)data;
+}
+
+static Node mapBuildTree(Map map,
+                         MapKeyElement *keys,
+                         MapDataElement *data,
+                         int count)
+{
+  // lowest tree that can hold all the elements
+  long capacity[MAP_MAX_DEPTH + 1];
+  int height = 1;
+
+  capacity[0] = 0;
+  capacity[1] = MAP_NODE_KEYS;
+  while (capacity[height] < count) {
+    capacity[height + 1] = (capacity[height] + 1) * (MAP_NODE_KEYS + 1) - 1;
+    height++;
+  }
+
+  return nodeBuild(map, keys, data, count, height, capacity);
+}
+
+static Node nodeBuild(Map map,
+                      MapKeyElement *keys,
+                      MapDataElement *data,
+                      int count,
+                      int height,
+                      const long *capacity)
+{
+  Node node = newNode(map, 1 == height);
+
+  if (NULL == node) {
+    return NULL;
+  }
+
+  if (node->leaf) {
+    for (int i = 0; i < count; i++) {
+      node->keys[i] = keys[i];
+      node->data[i] = data[i];
+    }
+    node->count = count;
+    return node;
+  }
+
+  // fewest children that can hold the elements, each gets an even share.
+  // an even share is at least half a full child, which is above the minimum
+  long child_capacity = capacity[height - 1];
+  int children = (int)((count + 1 + child_capacity) / (child_capacity + 1));
+  int child_keys = count - (children - 1);
+  int position = 0;
+
+  for (int i = 0; i < children; i++) {
+    int size = child_keys / children + ((i < child_keys % children) ? 1 : 0);
+
+    node->children[i] = nodeBuild(map, keys + position, data + position,
+                                  size, height - 1, capacity);
+    if (NULL == node->children[i]) {
+      node->count = i - 1;
+      if (i > 0) {
+        nodeFreeStructure(map, node);
+      } else {
+        nodeFree(map, node);
+      }
+      return NULL;
+    }
+    position += size;
+
+    if (i < children - 1) {
+      node->keys[i] = keys[position];
+      node->data[i] = data[position];
+      position++;
+    }
+  }
+  node->count = children - 1;
+
+  return node;
+}
+
+static Node mapFind(Map map, MapKeyElement key, int *index)
+{
+  Node current_node = map->root;
+
+  while (NULL != current_node) {
+    if (nodeSearch(map, current_node, key, index)) {
+      return current_node;
+    }
+    if (current_node->leaf) {
+      return NULL;
+    }
+    current_node = current_node->children[*index];
+  }
+
+  return NULL;
+}
+
+static bool nodeSearch(Map map, Node node, MapKeyElement key, int *index)
+{
+  int low = 0, high = node->count;
+
+  MAP_STAT(map, nodes_visited);
+  if (map->int_keyed) {
+    int int_key = *(int *)key;
+
+    while (low < high) {
+      int middle = low + (high - low) / 2;
+      int middle_key = *(int *)node->keys[middle];
+
+      MAP_STAT(map, comparisons);
+      if (middle_key == int_key) {
+        *index = middle;
+        return true;
+      }
+      if (middle_key < int_key) {
+        low = middle + 1;
+      } else {
+        high = middle;
+      }
+    }
+
+    *index = low;
+    return false;
+  }
+
+  while (low < high) {
+    int middle = low + (high - low) / 2;
+    int compare = map->compare(node->keys[middle], key);
+
+    MAP_STAT(map, comparisons);
+    if (0 == compare) {
+      *index = middle;
+      return true;
+    }
+    if (compare < 0) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  *index = low;
+  return false;
+}
+
+static void poolInit(Pool *pool, size_t element_size, int first_chunk, int max_chunk)
+{
+  pool->element_size = (element_size < sizeof(void *)) ? sizeof(void *) : element_size;
+  pool->chunk_capacity = first_chunk;
+  pool->first_chunk_capacity = first_chunk;
+  pool->max_chunk_capacity = max_chunk;
+  pool->chunks = NULL;
+  pool->unused = NULL;
+  pool->unused_count = 0;
+  pool->free_list = NULL;
+}
+
+static void *poolAlloc(Pool *pool)
+{
+  if (NULL != pool->free_list) {
+    void *element = pool->free_list;
+    pool->free_list = *(void **)element;
+    return element;
+  }
+
+  if (0 == pool->unused_count) {
+    PoolChunk chunk = (PoolChunk)malloc(sizeof(*chunk) +
+                                        pool->element_size * pool->chunk_capacity);
+    if (NULL == chunk) {
+      return NULL;
+    }
+
+    chunk->next = pool->chunks;
+    pool->chunks = chunk;
+    pool->unused = (char *)(chunk + 1);
+    pool->unused_count = pool->chunk_capacity;
+
+    if (2 * pool->chunk_capacity <= pool->max_chunk_capacity) {
+      pool->chunk_capacity *= 2;
+    }
+  }
+
+  void *element = pool->unused;
+  pool->unused += pool->element_size;
+  pool->unused_count--;
+  return element;
+}
+
+static void poolFree(Pool *pool, void *element)
+{
+  *(void **)element = pool->free_list;
+  pool->free_list = element;
+}
+
+static void poolRelease(Pool *pool)
+{
+  PoolChunk chunk = pool->chunks, next;
+
+  while (NULL != chunk) {
+    next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+
+  // a refilled pool grows from small chunks again
+  pool->chunk_capacity = pool->first_chunk_capacity;
+  pool->chunks = NULL;
+  pool->unused = NULL;
+  pool->unused_count = 0;
+  pool->free_list = NULL;
+}
+
+static Node newNode(Map map, bool leaf)
+{
+  Node new_node = map->persistent ? (Node)malloc(sizeof(*new_node)) :
+                                    (Node)poolAlloc(&map->nodes);
+
+  if (NULL == new_node) {
+    return NULL;
+  }
+
+  MAP_STAT(map, allocations);
+  new_node->count = 0;
+  new_node->refs = 1;
+  new_node->leaf = leaf;
+
+  return new_node;
+}
+
+static void nodeFree(Map map, Node node)
+{
+  MAP_STAT(map, frees);
+  if (map->persistent) {
+    free(node);
+    return;
+  }
+
+  poolFree(&map->nodes, node);
+}
+
+static void nodeFreeStructure(Map map, Node node)
+{
+  if (!node->leaf) {
+    for (int i = 0; i <= node->count; i++) {
+      nodeFreeStructure(map, node->children[i]);
+    }
+  }
+
+  nodeFree(map, node);
+}
+
+static void nodeRelease(Map map, Node node)
+{
+  if ((NULL == node) || (--node->refs > 0)) {
+    return;
+  }
+
+  for (int i = 0; i < node->count; i++) {
+    mapKeyFree(map, node->keys[i]);
+    map->freeData(node->data[i]);
+  }
+
+  if (!node->leaf) {
+    for (int i = 0; i <= node->count; i++) {
+      nodeRelease(map, node->children[i]);
+    }
+  }
+
+  nodeFree(map, node);
+}
+
+static Node nodeClone(Map map, Node node)
+{
+  Node clone = newNode(map, node->leaf);
+
+  if (NULL == clone) {
+    return NULL;
+  }
+
+  for (int i = 0; i < node->count; i++) {
+    MapKeyElement key_copy = mapKeyCopy(map, node->keys[i]);
+    MapDataElement data_copy = (NULL == key_copy) ? NULL :
+                                                    map->copyData(node->data[i]);
+
+    if (NULL == data_copy) {
+      if (NULL != key_copy) {
+        mapKeyFree(map, key_copy);
+      }
+      for (int j = 0; j < i; j++) {
+        mapKeyFree(map, clone->keys[j]);
+        map->freeData(clone->data[j]);
+      }
+      nodeFree(map, clone);
+      return NULL;
+    }
+
+    clone->keys[i] = key_copy;
+    clone->data[i] = data_copy;
+  }
+  clone->count = node->count;
+
+  if (!node->leaf) {
+    for (int i = 0; i <= node->count; i++) {
+      clone->children[i] = node->children[i];
+      clone->children[i]->refs++;
+    }
+  }
+
+  return clone;
+}
+
+static Node nodeWritable(Map map, Node *slot)
+{
+  Node node = *slot;
+
+  if (1 == node->refs) {
+    return node;
+  }
+
+  Node clone = nodeClone(map, node);
+  if (NULL == clone) {
+    return NULL;
+  }
+
+  // the original stays alive for its other owners
+  node->refs--;
+  *slot = clone;
+  return clone;
+}
+
+static void nodeClear(Map map, Node node)
+{
+  if (NULL == node) {
+    return;
+  }
+
+  // the node and its keys are freed, the node along with the pool
+  MAP_STAT_ADD(map, frees, 1 + node->count);
+  for (int i = 0; i < node->count; i++) {
+    // keys of int keyed maps go away with the key pool
+    if (!map->int_keyed) {
+      map->freeKey(node->keys[i]);
+    }
+    map->freeData(node->data[i]);
+  }
+
+  if (!node->leaf) {
+    for (int i = 0; i <= node->count; i++) {
+      nodeClear(map, node->children[i]);
+    }
+  }
+}
+
+static MapKeyElement mapKeyCopy(Map map, MapKeyElement key)
+{
+  MAP_STAT(map, allocations);
+  if (!map->int_keyed) {
+    return map->copyKey(key);
+  }
+
+  int *copy = (int *)poolAlloc(&map->keys);
+  if (NULL == copy) {
+    return NULL;
+  }
+
+  *copy = *(int *)key;
+  return copy;
+}
+
+static void mapKeyFree(Map map, MapKeyElement key)
+{
+  MAP_STAT(map, frees);
+  if (!map->int_keyed) {
+    map->freeKey(key);
+    return;
+  }
+
+  poolFree(&map->keys, key);
+}
+
+static bool nodeSplitChild(Map map, Node parent, int index)
+{
+  Node full = parent->children[index];
+  Node sibling = newNode(map, full->leaf);
+
+  if (NULL == sibling) {
+    return false;
+  }
+
+  // upper half of the full node moves to the new sibling
+  sibling->count = MAP_MIN_DEGREE - 1;
+  for (int i = 0; i < MAP_MIN_DEGREE - 1; i++) {
+    sibling->keys[i] = full->keys[i + MAP_MIN_DEGREE];
+    sibling->data[i] = full->data[i + MAP_MIN_DEGREE];
+  }
+  if (!full->leaf) {
+    for (int i = 0; i < MAP_MIN_DEGREE; i++) {
+      sibling->children[i] = full->children[i + MAP_MIN_DEGREE];
+    }
+  }
+  full->count = MAP_MIN_DEGREE - 1;
+
+  // make room for the median in the parent
+  for (int i = parent->count; i > index; i--) {
+    parent->keys[i] = parent->keys[i - 1];
+    parent->data[i] = parent->data[i - 1];
+    parent->children[i + 1] = parent->children[i];
+  }
+  parent->keys[index] = full->keys[MAP_MIN_DEGREE - 1];
+  parent->data[index] = full->data[MAP_MIN_DEGREE - 1];
+  parent->children[index + 1] = sibling;
+  parent->count++;
+
+  return true;
+}
+
+static void nodeMergeChildren(Map map, Node parent, int index)
+{
+  Node left = parent->children[index];
+  Node right = parent->children[index + 1];
+
+  assert(MAP_MIN_DEGREE - 1 == left->count);
+  assert(MAP_MIN_DEGREE - 1 == right->count);
+
+  // separating key moves down to the middle of the merged node
+  left->keys[left->count] = parent->keys[index];
+  left->data[left->count] = parent->data[index];
+
+  for (int i = 0; i < right->count; i++) {
+    left->keys[left->count + 1 + i] = right->keys[i];
+    left->data[left->count + 1 + i] = right->data[i];
+  }
+  if (!left->leaf) {
+    for (int i = 0; i <= right->count; i++) {
+      left->children[left->count + 1 + i] = right->children[i];
+    }
+  }
+  left->count += right->count + 1;
+
+  for (int i = index; i < parent->count - 1; i++) {
+    parent->keys[i] = parent->keys[i + 1];
+    parent->data[i] = parent->data[i + 1];
+    parent->children[i + 1] = parent->children[i + 2];
+  }
+  parent->count--;
+
+  nodeFree(map, right);
+}
+
+static int nodeFillChild(Map map, Node parent, int index)
+{
+  Node child = nodeWritable(map, &parent->children[index]);
+
+  if (NULL == child) {
+    return -1;
+  }
+
+  if (child->count >= MAP_MIN_DEGREE) {
+    return index;
+  }
+
+  // borrow the largest key of the left sibling through the parent
+  if ((index > 0) && (parent->children[index - 1]->count >= MAP_MIN_DEGREE)) {
+    Node left = nodeWritable(map, &parent->children[index - 1]);
+    if (NULL == left) {
+      return -1;
+    }
+
+    for (int i = child->count; i > 0; i--) {
+      child->keys[i] = child->keys[i - 1];
+      child->data[i] = child->data[i - 1];
+    }
+    if (!child->leaf) {
+      for (int i = child->count + 1; i > 0; i--) {
+        child->children[i] = child->children[i - 1];
+      }
+      child->children[0] = left->children[left->count];
+    }
+    child->keys[0] = parent->keys[index - 1];
+    child->data[0] = parent->data[index - 1];
+    child->count++;
+
+    parent->keys[index - 1] = left->keys[left->count - 1];
+    parent->data[index - 1] = left->data[left->count - 1];
+    left->count--;
+    return index;
+  }
+
+  // borrow the smallest key of the right sibling through the parent
+  if ((index < parent->count) &&
+      (parent->children[index + 1]->count >= MAP_MIN_DEGREE)) {
+    Node right = nodeWritable(map, &parent->children[index + 1]);
+    if (NULL == right) {
+      return -1;
+    }
+
+    child->keys[child->count] = parent->keys[index];
+    child->data[child->count] = parent->data[index];
+    if (!child->leaf) {
+      child->children[child->count + 1] = right->children[0];
+    }
+    child->count++;
+
+    parent->keys[index] = right->keys[0];
+    parent->data[index] = right->data[0];
+    for (int i = 0; i < right->count - 1; i++) {
+      right->keys[i] = right->keys[i + 1];
+      right->data[i] = right->data[i + 1];
+    }
+    if (!right->leaf) {
+      for (int i = 0; i < right->count; i++) {
+        right->children[i] = right->children[i + 1];
+      }
+    }
+    right->count--;
+    return index;
+  }
+
+  // both siblings are minimal, merge with one of them
+  if (index < parent->count) {
+    if (NULL == nodeWritable(map, &parent->children[index + 1])) {
+      return -1;
+    }
+    nodeMergeChildren(map, parent, index);
+    return index;
+  }
+
+  if (NULL == nodeWritable(map, &parent->children[index - 1])) {
+    return -1;
+  }
+  nodeMergeChildren(map, parent, index - 1);
+  return index - 1;
+}
+
+static MapResult nodeDetach(Map map,
+                            Node node,
+                            MapKeyElement key,
+                            MapKeyElement *out_key,
+                            MapDataElement *out_data)
+{
+  int index;
+  bool found = nodeSearch(map, node, key, &index);
+
+  if (found && node->leaf) {
+    *out_key = node->keys[index];
+    *out_data = node->data[index];
+    for (int i = index; i < node->count - 1; i++) {
+      node->keys[i] = node->keys[i + 1];
+      node->data[i] = node->data[i + 1];
+    }
+    node->count--;
+    return MAP_SUCCESS;
+  }
+
+  if (node->leaf) {
+    return MAP_ITEM_DOES_NOT_EXIST;
+  }
+
+  if (found) {
+    Node left = node->children[index];
+    Node right = node->children[index + 1];
+
+    if ((left->count < MAP_MIN_DEGREE) && (right->count < MAP_MIN_DEGREE)) {
+      left = nodeWritable(map, &node->children[index]);
+      if ((NULL == left) ||
+          (NULL == nodeWritable(map, &node->children[index + 1]))) {
+        return MAP_OUT_OF_MEMORY;
+      }
+      // key moves down into the merged child and is removed from there
+      nodeMergeChildren(map, node, index);
+      return nodeDetach(map, left, key, out_key, out_data);
+    }
+
+    // replace the key with its predecessor or successor, which is in a leaf
+    bool from_left = left->count >= MAP_MIN_DEGREE;
+    Node source = nodeWritable(map, &node->children[from_left ? index : index + 1]);
+    if (NULL == source) {
+      return MAP_OUT_OF_MEMORY;
+    }
+
+    Node replacement = source;
+    int replacement_index;
+
+    if (from_left) {
+      while (!replacement->leaf) {
+        replacement = replacement->children[replacement->count];
+      }
+      replacement_index = replacement->count - 1;
+    } else {
+      while (!replacement->leaf) {
+        replacement = replacement->children[0];
+      }
+      replacement_index = 0;
+    }
+
+    MapKeyElement detached_key = node->keys[index];
+    MapDataElement detached_data = node->data[index];
+    MapKeyElement replacement_key = replacement->keys[replacement_index];
+
+    MapResult result = nodeDetach(map, source, replacement_key,
+                                  &node->keys[index], &node->data[index]);
+    if (MAP_SUCCESS != result) {
+      return result;
+    }
+
+    *out_key = detached_key;
+    *out_data = detached_data;
+    return MAP_SUCCESS;
+  }
+
+  index = nodeFillChild(map, node, index);
+  if (index < 0) {
+    return MAP_OUT_OF_MEMORY;
+  }
+
+  return nodeDetach(map, node->children[index], key, out_key, out_data);
+}
+
+static void iteratorDescendLeftmost(MapIterator *iterator, Node node)
+{
+  while (true) {
+    iterator->path[iterator->depth] = node;
+    iterator->path_index[iterator->depth] = 0;
+    iterator->depth++;
+
+    if (node->leaf) {
+      return;
+    }
+    node = node->children[0];
+  }
+}
+
+static void iteratorAdvance(MapIterator *iterator)
+{
+  int top = iterator->depth - 1;
+  Node current = iterator->path[top];
+  int index = iterator->path_index[top];
+
+  // next key is the leftmost key of the subtree right after the current key
+  if (!current->leaf) {
+    iterator->path_index[top] = index + 1;
+    iteratorDescendLeftmost(iterator, current->children[index + 1]);
+    return;
+  }
+
+  iterator->path_index[top] = index + 1;
+  iteratorClimb(iterator);
+}
+
+static void iteratorClimb(MapIterator *iterator)
+{
+  // subtree exhausted, climb up until an ancestor has keys left
+  while (iterator->depth > 0) {
+    int top = iterator->depth - 1;
+    if (iterator->path_index[top] < iterator->path[top]->count) {
+      return;
+    }
+    iterator->depth--;
+  }
+}
+
+static void iteratorCheckEnd(MapIterator *iterator)
+{
+  if ((NULL != iterator->end) && mapIteratorValid(iterator) &&
+      (iterator->compare(mapIteratorKey(iterator), iterator->end) > 0)) {
+    iterator->depth = 0;
+  }
+}
+
+static MapKeyElement copyIntKey(MapKeyElement key)
+{
+  int *copy = (int *)malloc(sizeof(*copy));
+
+  if (NULL == copy) {
+    return NULL;
+  }
+
+  *copy = *(int *)key;
+  return copy;
+}
+
+static void freeIntKey(MapKeyElement key)
+{
+  free(key);
+}
+
+static int compareIntKeys(MapKeyElement first, MapKeyElement second)
+{
+  int first_key = *(int *)first, second_key = *(int *)second;
+
+  return (first_key > second_key) - (first_key < second_key);
+}
+
+/**
+ * Fibonacci hashing of an int key into the index range. The high bits of the
+ * product are folded in, since the low ones mix poorly.
+ */
+static inline int mapIndexHash(Map map, int key)
+{
+  unsigned int hash = (unsigned int)key * 2654435769u;
+
+  return (int)((hash ^ (hash >> 16)) & (unsigned int)(map->index_capacity - 1));
+}
+
+static IndexSlot mapIndexFind(Map map, int key)
+{
+  int slot = mapIndexHash(map, key);
+
+  MAP_STAT(map, index_probes);
+  while ((NULL != map->index[slot].data) && (key != map->index[slot].key)) {
+    slot = (slot + 1) & (map->index_capacity - 1);
+    MAP_STAT(map, index_probes);
+  }
+
+  return &map->index[slot];
+}
+
+static bool mapIndexReserve(Map map, int count)
+{
+  if ((NULL == map->index) && (map->keys_count + count <= MAP_INDEX_MIN_KEYS)) {
+    return true;
+  }
+
+  int new_capacity = (NULL == map->index) ? MAP_INDEX_INITIAL_CAPACITY :
+                                            map->index_capacity;
+
+  while (2 * (map->keys_count + count) > new_capacity) {
+    new_capacity *= 2;
+  }
+  if (new_capacity == map->index_capacity) {
+    return true;
+  }
+
+  IndexSlot old_index = map->index;
+  int old_capacity = map->index_capacity;
+
+  map->index = (IndexSlot)calloc(new_capacity, sizeof(*map->index));
+  if (NULL == map->index) {
+    map->index = old_index;
+    return false;
+  }
+  MAP_STAT(map, allocations);
+  map->index_capacity = new_capacity;
+
+  if (NULL == old_index) {
+    // the map just outgrew the single leaf, index the keys it already has
+    MAP_ITERATE(iterator, map) {
+      mapIndexPut(map, *(int *)mapIteratorKey(&iterator),
+                  mapIteratorData(&iterator));
+    }
+    return true;
+  }
+
+  for (int i = 0; i < old_capacity; i++) {
+    if (NULL != old_index[i].data) {
+      mapIndexPut(map, old_index[i].key, old_index[i].data);
+    }
+  }
+
+  MAP_STAT(map, frees);
+  free(old_index);
+  return true;
+}
+
+static void mapIndexPut(Map map, int key, MapDataElement data)
+{
+  IndexSlot slot = mapIndexFind(map, key);
+
+  slot->key = key;
+  slot->data = data;
+}
+
+static void mapIndexRemove(Map map, int key)
+{
+  int mask = map->index_capacity - 1;
+  int hole = (int)(mapIndexFind(map, key) - map->index);
+
+  if (NULL == map->index[hole].data) {
+    return;
+  }
+
+  // move back every following key whose home slot is not between the
+  // hole and its current slot, so lookups never stop at the hole
+  int slot = hole;
+  while (true) {
+    slot = (slot + 1) & mask;
+    if (NULL == map->index[slot].data) {
+      break;
+    }
+
+    int home = mapIndexHash(map, map->index[slot].key);
+    if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+      map->index[hole] = map->index[slot];
+      hole = slot;
+    }
+  }
+
+  map->index[hole].data = NULL;
+}
+
+static void mapReset(Map map)
+{
+  if (NULL == map) {
+    return;
+  }
+
+  map->current.depth = 0;
+}
+
+static void streamPutNumber(unsigned char *bytes, unsigned long value)
+{
+  for (int i = 0; i < MAP_STREAM_LENGTH_SIZE; i++) {
+    bytes[i] = (unsigned char)((value >> (8 * i)) & 0xff);
+  }
+}
+
+static unsigned long streamGetNumber(const unsigned char *bytes)
+{
+  unsigned long value = 0;
+
+  for (int i = 0; i < MAP_STREAM_LENGTH_SIZE; i++) {
+    value |= (unsigned long)bytes[i] << (8 * i);
+  }
+
+  return value;
+}
+
+static bool streamReserve(unsigned char **buffer, int *capacity, int needed)
+{
+  if (needed <= *capacity) {
+    return true;
+  }
+
+  int new_capacity = (0 == *capacity) ? MAP_STREAM_BUFFER_SIZE : *capacity;
+  while (new_capacity < needed) {
+    new_capacity *= 2;
+  }
+
+  unsigned char *grown = (unsigned char *)realloc(*buffer, new_capacity);
+  if (NULL == grown) {
+    return false;
+  }
+
+  *buffer = grown;
+  *capacity = new_capacity;
+  return true;
+}
+
+static MapResult streamAppendElement(encodeMapElement encode,
+                                     void *element,
+                                     unsigned char **record,
+                                     int *capacity,
+                                     int *size)
+{
+  int offset = *size + MAP_STREAM_LENGTH_SIZE;
+
+  if (!streamReserve(record, capacity, offset)) {
+    return MAP_OUT_OF_MEMORY;
+  }
+
+  int length = encode(element, *record + offset, *capacity - offset);
+  if ((length < 0) || (length > MAP_STREAM_MAX_ELEMENT)) {
+    return MAP_ERROR;
+  }
+
+  // the buffer was too small, encode again into a big enough one
+  if (length > *capacity - offset) {
+    if (!streamReserve(record, capacity, offset + length)) {
+      return MAP_OUT_OF_MEMORY;
+    }
+    if (encode(element, *record + offset, length) != length) {
+      return MAP_ERROR;
+    }
+  }
+
+  streamPutNumber(*record + *size, (unsigned long)length);
+  *size = offset + length;
+  return MAP_SUCCESS;
+}
+
+static MapResult streamReadElement(FILE *stream,
+                                   decodeMapElement decode,
+                                   unsigned char **buffer,
+                                   int *capacity,
+                                   void **element)
+{
+  unsigned char length_bytes[MAP_STREAM_LENGTH_SIZE];
+
+  if (1 != fread(length_bytes, sizeof(length_bytes), 1, stream)) {
+    return MAP_ERROR;
+  }
+
+  unsigned long length = streamGetNumber(length_bytes);
+  if (length > MAP_STREAM_MAX_ELEMENT) {
+    return MAP_ERROR;
+  }
+  if (!streamReserve(buffer, capacity, (int)length + 1)) {
+    return MAP_OUT_OF_MEMORY;
+  }
+  if ((length > 0) && (1 != fread(*buffer, length, 1, stream))) {
+    return MAP_ERROR;
+  }
+
+  *element = decode(*buffer, (int)length);
+  return (NULL == *element) ? MAP_ERROR : MAP_SUCCESS;
+}
@@ -0,0 +1,296 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "read_mostly_map.h"
+
+/**
+ * The read mostly map keeps its current version in a persistent Map, which
+ * readers load with an atomic acquire. A writer copies the current version in
+ * O(1), changes the copy (copying only the nodes on its path, the rest is
+ * shared with the current version) and publishes it with an atomic release.
+ *
+ * Reclamation is epoch based. The map has a global epoch, and every reader
+ * records the epoch it saw when it entered its read section (0 when outside
+ * of one). A replaced version is retired with the epoch during which it was
+ * replaced, and the global epoch is advanced. Readers which entered after
+ * that cannot see the replaced version, so it is destroyed once no reader is
+ * left in an epoch up to the one it was retired with.
+ *
+ * The atomics are the GCC/Clang __atomic builtins, which keep the container
+ * within C99 like the rest of the repository.
+ */
+
+/** A replaced version of the map, waiting for its readers to leave */
+typedef struct RetiredVersion_t {
+  Map version;
+  unsigned long epoch;
+  struct RetiredVersion_t *next;
+} *RetiredVersion;
+
+struct ReadMostlyMapReader_t {
+  ReadMostlyMap map;
+  unsigned long epoch;  // epoch of the current read section, 0 outside one
+  struct ReadMostlyMapReader_t *next;
+};
+
+struct ReadMostlyMap_t {
+  Map current;
+  unsigned long epoch;
+  pthread_mutex_t writer;  // guards everything below
+  ReadMostlyMapReader readers;
+  RetiredVersion retired;
+};
+
+/** Type of the changes a writer applies to a copy of the current version */
+typedef MapResult (*updateMap)(Map, MapKeyElement, MapDataElement);
+
+/**
+ * Applies a change to a copy of the current version and publishes the copy.
+ *
+ * @param map - map to change
+ * @param update - the change to apply
+ * @param key - key argument of update
+ * @param data - data argument of update
+ * @return
+ *    MAP_OUT_OF_MEMORY on memory allocation error, the result of update
+ *    otherwise. The copy is published only if update returned MAP_SUCCESS.
+ */
+static MapResult readMostlyMapUpdate(ReadMostlyMap map,
+                                     updateMap update,
+                                     MapKeyElement key,
+                                     MapDataElement data);
+
+/**
+ * Destroys the retired versions no reader may still be using.
+ * Called with the writer mutex held.
+ *
+ * @param map - map in question
+ */
+static void readMostlyMapReclaim(ReadMostlyMap map);
+
+/**
+ * mapRemove in the form of updateMap, data is ignored.
+ */
+static MapResult removeKey(Map map, MapKeyElement key, MapDataElement data);
+
+ReadMostlyMap readMostlyMapCreate(copyMapDataElements copyDataElement,
+                                  copyMapKeyElements copyKeyElement,
+                                  freeMapDataElements freeDataElement,
+                                  freeMapKeyElements freeKeyElement,
+                                  compareMapKeyElements compareKeyElements)
+{
+  ReadMostlyMap map = malloc(sizeof(*map));
+  if (NULL == map) {
+    return NULL;
+  }
+
+  map->current = mapCreatePersistent(copyDataElement, copyKeyElement,
+                                     freeDataElement, freeKeyElement,
+                                     compareKeyElements);
+  if (NULL == map->current) {
+    free(map);
+    return NULL;
+  }
+
+  if (0 != pthread_mutex_init(&map->writer, NULL)) {
+    mapDestroy(map->current);
+    free(map);
+    return NULL;
+  }
+
+  map->epoch = 1;
+  map->readers = NULL;
+  map->retired = NULL;
+
+  return map;
+}
+
+void readMostlyMapDestroy(ReadMostlyMap map)
+{
+  if (NULL == map) {
+    return;
+  }
+
+  while (NULL != map->retired) {
+    RetiredVersion next = map->retired->next;
+    mapDestroy(map->retired->version);
+    free(map->retired);
+    map->retired = next;
+  }
+
+  while (NULL != map->readers) {
+    ReadMostlyMapReader next = map->readers->next;
+    free(map->readers);
+    map->readers = next;
+  }
+
+  mapDestroy(map->current);
+  pthread_mutex_destroy(&map->writer);
+  free(map);
+}
+
+ReadMostlyMapReader readMostlyMapRegisterReader(ReadMostlyMap map)
+{
+  if (NULL == map) {
+    return NULL;
+  }
+
+  ReadMostlyMapReader reader = malloc(sizeof(*reader));
+  if (NULL == reader) {
+    return NULL;
+  }
+
+  reader->map = map;
+  reader->epoch = 0;
+
+  pthread_mutex_lock(&map->writer);
+  reader->next = map->readers;
+  map->readers = reader;
+  pthread_mutex_unlock(&map->writer);
+
+  return reader;
+}
+
+void readMostlyMapUnregisterReader(ReadMostlyMapReader reader)
+{
+  if (NULL == reader) {
+    return;
+  }
+
+  ReadMostlyMap map = reader->map;
+
+  pthread_mutex_lock(&map->writer);
+  ReadMostlyMapReader *link = &map->readers;
+  while (*link != reader) {
+    link = &(*link)->next;
+  }
+  *link = reader->next;
+  pthread_mutex_unlock(&map->writer);
+
+  free(reader);
+}
+
+Map readMostlyMapReadBegin(ReadMostlyMapReader reader)
+{
+  if (NULL == reader) {
+    return NULL;
+  }
+
+  ReadMostlyMap map = reader->map;
+
+  // the epoch must be visible to writers before the version is loaded, so a
+  // writer either sees this reader or has already published a newer version
+  unsigned long epoch = __atomic_load_n(&map->epoch, __ATOMIC_SEQ_CST);
+  __atomic_store_n(&reader->epoch, epoch, __ATOMIC_SEQ_CST);
+
+  return __atomic_load_n(&map->current, __ATOMIC_SEQ_CST);
+}
+
+void readMostlyMapReadEnd(ReadMostlyMapReader reader)
+{
+  if (NULL == reader) {
+    return;
+  }
+
+  __atomic_store_n(&reader->epoch, 0, __ATOMIC_RELEASE);
+}
+
+MapResult readMostlyMapPut(ReadMostlyMap map,
+                           MapKeyElement keyElement,
+                           MapDataElement dataElement)
+{
+  if ((NULL == map) || (NULL == keyElement) || (NULL == dataElement)) {
+    return MAP_NULL_ARGUMENT;
+  }
+
+  return readMostlyMapUpdate(map, mapPut, keyElement, dataElement);
+}
+
+MapResult readMostlyMapPutOwned(ReadMostlyMap map,
+                                MapKeyElement keyElement,
+                                MapDataElement dataElement)
+{
+  if ((NULL == map) || (NULL == keyElement) || (NULL == dataElement)) {
+    return MAP_NULL_ARGUMENT;
+  }
+
+  return readMostlyMapUpdate(map, mapPutOwned, keyElement, dataElement);
+}
+
+MapResult readMostlyMapRemove(ReadMostlyMap map, MapKeyElement keyElement)
+{
+  if ((NULL == map) || (NULL == keyElement)) {
+    return MAP_NULL_ARGUMENT;
+  }
+
+  return readMostlyMapUpdate(map, removeKey, keyElement, NULL);
+}
+
+static MapResult readMostlyMapUpdate(ReadMostlyMap map,
+                                     updateMap update,
+                                     MapKeyElement key,
+                                     MapDataElement data)
+{
+  RetiredVersion retired = malloc(sizeof(*retired));
+  if (NULL == retired) {
+    return MAP_OUT_OF_MEMORY;
+  }
+
+  pthread_mutex_lock(&map->writer);
+
+  Map version = mapCopy(map->current);
+  MapResult result = (NULL == version) ? MAP_OUT_OF_MEMORY :
+                                         update(version, key, data);
+
+  if (MAP_SUCCESS != result) {
+    pthread_mutex_unlock(&map->writer);
+    mapDestroy(version);
+    free(retired);
+    return result;
+  }
+
+  retired->version = map->current;
+  __atomic_store_n(&map->current, version, __ATOMIC_SEQ_CST);
+
+  // readers entering from the next epoch on load the new version
+  retired->epoch = __atomic_fetch_add(&map->epoch, 1, __ATOMIC_SEQ_CST);
+  retired->next = map->retired;
+  map->retired = retired;
+
+  readMostlyMapReclaim(map);
+  pthread_mutex_unlock(&map->writer);
+
+  return MAP_SUCCESS;
+}
+
+static void readMostlyMapReclaim(ReadMostlyMap map)
+{
+  // the oldest epoch a reader may still be reading in
+  unsigned long oldest = __atomic_load_n(&map->epoch, __ATOMIC_SEQ_CST);
+  for (ReadMostlyMapReader reader = map->readers; NULL != reader;
+       reader = reader->next) {
+    unsigned long epoch = __atomic_load_n(&reader->epoch, __ATOMIC_SEQ_CST);
+    if ((0 != epoch) && (epoch < oldest)) {
+      oldest = epoch;
+    }
+  }
+
+  RetiredVersion *link = &map->retired;
+  while (NULL != *link) {
+    RetiredVersion retired = *link;
+    if (retired->epoch < oldest) {
+      *link = retired->next;
+      mapDestroy(retired->version);
+      free(retired);
+    } else {
+      link = &retired->next;
+    }
+  }
+}
+
+static MapResult removeKey(Map map, MapKeyElement key, MapDataElement data)
+{
+  (void)data;
+  return mapRemove(map, key);
+}
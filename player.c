@@ -1,11 +1,16 @@
 #include "player.h"
-#include "matchnode.h"
+#include "matchvector.h"
 
 //Need to go over create, destroy and copy
 
 struct player_t {
   int id;
-  matchNode matches;
+  MatchVector matches;
+  //running totals over the matches, kept so the score and play time are O(1)
+  int wins;
+  int draws;
+  int losses;
+  long total_play_time;
 };
 
 Player playerCreate(int id)
@@ -14,13 +19,22 @@ Player playerCreate(int id)
   {
     return NULL;
   }
-  Player player = (Player) malloc(sizeof(struct Player));
-  if(player == NULL || matches == NULL)
+  Player player = (Player) malloc(sizeof(*player));
+  if(player == NULL)
   {
     return NULL;
   }
   player->id = id; 
-  player->matches = NULL;
+  player->wins = 0;
+  player->draws = 0;
+  player->losses = 0;
+  player->total_play_time = 0;
+  player->matches = matchVectorCreate(MATCH_HOOK_PLAYER, player);
+  if(player->matches == NULL)
+  {
+    free(player);
+    return NULL;
+  }
   return player;
 }
 
@@ -33,7 +47,7 @@ int playerGetId(Player player)
   return player->id;
 }
 
-matchNode playerGetMatches(Player player)
+MatchVector playerGetMatches(Player player)
 {
   if(player == NULL)
   {
@@ -48,10 +62,12 @@ ChessResult playerAddMatch(Player player, Match match)
   {
     return CHESS_NULL_ARGUMENT;
   }
-  if(!newMatchNode(match, player->matches)) //trying to add a new MatchNode to matches' list
+  if(matchVectorPush(player->matches, match) != CHESS_SUCCESS)
   {
     return CHESS_OUT_OF_MEMORY;
   }
+  playerCountResult(player, match, true);
+  player->total_play_time += matchGetDuration(match);
   return CHESS_SUCCESS;
 }
 
@@ -61,80 +77,90 @@ ChessResult playerRemoveMatch(Player player, Match match)
   {
     return CHESS_NULL_ARGUMENT;
   }
-  matchNodeRemove(player->matches, match);
+  if(matchVectorRemove(player->matches, match))
+  {
+    playerCountResult(player, match, false);
+    player->total_play_time -= matchGetDuration(match);
+  }
   return CHESS_SUCCESS;
 }
 
+void playerCountResult(Player player, Match match, bool count)
+{
+  if(player == NULL || match == NULL)
+  {
+    return;
+  }
+  int change = count ? 1 : -1;
+  //the result is kept by seat, as the opponent may have been removed already
+  Winner result = matchGetResult(match);
+  Winner seat = (matchGetFirst(match) == player) ? FIRST_PLAYER : SECOND_PLAYER;
+  if(result == seat) //this player won
+  {
+    player->wins += change;
+  }
+  else if(result == DRAW) //draw
+  {
+    player->draws += change;
+  }
+  else{ //the player lost
+    player->losses += change;
+  }
+}
+
+double playerGetAveragePlayTime(Player player)
+{
+  int number_of_games = matchVectorGetSize(playerGetMatches(player));
+  if(number_of_games == 0)
+  {
+    return 0;
+  }
+  return (double) player->total_play_time / number_of_games;
+}
+
 double playerGetScore(Player player)
 {
   if(player == NULL)
   {
     return 0;
   }
-  double score = 0;
-  MatchNode ptr = player->matches;
-  Match toCheck;
-  Player* temp;
-  while(ptr)
-  {
-    toCheck = getMatchFromMatchNode(ptr);
-    temp = matchGetWinner(toCheck); 
-    if(temp == &player) //this player won
-    {
-      score += 6;
-    }
-    else if(temp == NULL) //draw
-    {
-      score += 2;
-    }
-    else{ //the player lost
-      score += -10;
-    }
-    ptr = nextMatchNode(ptr);
-  }
+  int number_of_games = matchVectorGetSize(player->matches);
+  //the results are counted as the matches are added, so no match is visited
+  double score = 6 * player->wins + 2 * player->draws - 10 * player->losses;
 
-  int number_of_games = getSize(player->matches);
+  if(number_of_games == 0)
+  {
+    return 0;
+  }
   return score/ number_of_games; 
 }
 
-double playerCompare(Player player1, Player player2)
+int playerCompare(Player player1, Player player2)
 {
   //NO CHECK FOR NULL ARGUMENT  
   double score1 = playerGetScore(player1);
   double score2 = playerGetScore(player2);
-  return (int)(score1-score2);
+  //the sign of the difference, as a fraction of a point would be truncated to 0
+  return (score1 > score2) - (score1 < score2);
 }
 
-void playerDestroy(Player player, bool remove_from_tournaments)
+void playerDestroy(Player player, bool remove_from_matches)
 {
   if(player == NULL)
   {
     return;
   }
-  if(!remove_from_tournaments) //just freeing the player, without changing games he plays
+  if(!remove_from_matches) //just freeing the player, without changing games he plays
   {
-    MatchNode ptr = player->matches;
-    MatchNode toDelete;
-    while(ptr)
-    {
-      toDelete = ptr;
-      ptr = nextMatchNode(ptr);
-      matchNodeDestroy(toDelete, false);
-    }
+    matchVectorDestroy(player->matches, false);
     free(player);
     return;
   }
-  //setting all games in runnning tournements that [player] played so that he's the loser
-  matchNode ptr = player->matches;
-  while(ptr)
+  //the games outlive the player, so they must no longer point at him
+  Match *matches = matchVectorData(player->matches);
+  for(int i = 0; i < matchVectorGetSize(player->matches); i++)
   {
-    Match current = getMatchFromMatchNode(ptr);
-    Tournament current_tour = matchGetTournament(current));
-    if(tournamentIsEnded == false) //if tournament is still running 
-    {
-      matchSetLoser(current, player); //set player as the loser
-    }
-    ptr = nextMatchNode(ptr);
+    matchRemovePlayer(matches[i], player);
   }
   //now freeing the player using same func with false value
   playerDestroy(player, false);
@@ -152,16 +178,18 @@ Player playerCopy(Player original)
   {
     return NULL;
   }
-  matchNode list_of_matches = playerGetMatches(original);
-  while(list_of_matches) //copying matches
+  //the copy refers to the same matches
+  MatchVector list_of_matches = matchVectorCopy(playerGetMatches(original));
+  if(list_of_matches == NULL) //memory issue occured
   {
-    Match copy_match = matchCopy(list_of_matches);
-    if(playerAddMatch(new_player, copy_match) != CHESS_SUCCESS) //memory issue occured
-    {
-      playerDestroy(new_player);
-      return NULL;
-    }
-    list_of_matches = nextMatchNode(list_of_matches);
+    playerDestroy(new_player, false);
+    return NULL;
   }
+  matchVectorDestroy(new_player->matches, false);
+  new_player->matches = list_of_matches;
+  new_player->wins = original->wins;
+  new_player->draws = original->draws;
+  new_player->losses = original->losses;
+  new_player->total_play_time = original->total_play_time;
   return new_player;
 }
\ No newline at end of file
@@ -1,10 +1,12 @@
 #ifndef PLAYER_H
 #define PLAYER_H
 
+typedef struct player_t *Player;
+
 #include "chessSystem.h"
 #include "map.h"
-
-typedef struct player_t *Player;
+#include "match.h"
+#include "matchvector.h"
 
 /**
  * Creates a new instance of Player
@@ -28,17 +30,18 @@ Player playerCreate(int id);
 int playerGetId(Player player);
 
 /**
- * Retrieves a player's list of matches
+ * Retrieves a player's matches
  * 
  * @param player Player in question
  * @return 
- *    first pointer to matches list 
+ *    MatchVector of the player's matches, owned by the player
  *    NUll if provided player was NULL
  */
-matchNode playerGetMatches(Player player);
+MatchVector playerGetMatches(Player player);
 
 /**
- * Adds a match to player's record.
+ * Adds a match to player's record, and counts its result and duration in the
+ * player's running totals.
  * 
  * @param player Player in question
  * @param Match match to be added
@@ -50,7 +53,7 @@ matchNode playerGetMatches(Player player);
 ChessResult playerAddMatch(Player player, Match match);
 
 /**
- * Removes a match from player's record.
+ * Removes a match from player's record, and from the player's running totals.
  * 
  * @param player Player in question
  * @param Match match to be removed
@@ -61,7 +64,28 @@ ChessResult playerAddMatch(Player player, Match match);
 ChessResult playerRemoveMatch(Player player, Match match);
 
 /**
- * Calculates Player's score throughout the games in the system
+ * Counts the result of a match in the player's running totals of wins, draws
+ * and losses, or takes it out of them. Used when the result of a match in the
+ * player's record changes (see matchSetWinner).
+ * 
+ * @param player Player in question
+ * @param match Match in the player's record
+ * @param count true to count the current result, false to take it out
+ */
+void playerCountResult(Player player, Match match, bool count);
+
+/**
+ * Calculates the average duration of the player's games, in O(1)
+ * 
+ * @param player Player in question
+ * @return
+ *    Average duration of the player's games
+ *    0.0 if the player has no games or NULL argument was provided
+ */
+double playerGetAveragePlayTime(Player player);
+
+/**
+ * Calculates Player's score throughout the games in the system, in O(1)
  * 
  * @param player Player to be scored
  * @return
@@ -91,12 +115,16 @@ int playerCompare(Player player1, Player player2);
  * Destroys a Player instance and frees all private memory.
  * 
  * @param player Player to be destroyed.
- * @param remove_from_tournaments set as loser in running turnaments
+ * @param remove_from_matches take the player out of his matches, which stay
+ *                            in their tournaments (see matchRemovePlayer).
+ *                            The tournaments should already have removed him,
+ *                            see tournamentRemovePlayer.
  */
-void playerDestroy(Player player, bool remove_from_tournaments);
+void playerDestroy(Player player, bool remove_from_matches);
 
 /**
  * Creates a copy of the provided Player for the Map object.
+ * The copy refers to the same Match instances as the original.
  * 
  * @param original Player to be copied
  * @return 
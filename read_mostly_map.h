@@ -0,0 +1,156 @@
+#ifndef READ_MOSTLY_MAP_H_
+#define READ_MOSTLY_MAP_H_
+
+#include <stdbool.h>
+#include "map.h"
+
+/**
+* Read Mostly Map Container
+*
+* A map for data which is read by many threads far more often than it
+* changes. Readers never take locks: they enter a read section, get the
+* current version of the map and use it as an ordinary (read only) Map.
+* Writers serialize on a mutex, change a persistent copy of the current
+* version (see mapCreatePersistent) and publish it atomically, so a write
+* copies only the O(log n) nodes on its path.
+* A replaced version is freed once every reader that could have seen it has
+* left its read section (epoch based reclamation).
+*
+* A thread must register a reader before reading, and use that reader from
+* that thread only.
+*
+* The following functions are available:
+*   readMostlyMapCreate	- Creates a new empty map
+*   readMostlyMapDestroy	- Deletes an existing map and frees all resources
+*   readMostlyMapRegisterReader - Registers a reader of the map for the
+*   				  calling thread
+*   readMostlyMapUnregisterReader - Unregisters a reader and frees it
+*   readMostlyMapReadBegin	- Enters a read section, returns the current
+*   				  version of the map
+*   readMostlyMapReadEnd	- Leaves a read section
+*   readMostlyMapPut		- Gives a specific key a given value
+*   readMostlyMapPutOwned	- Gives a specific key a given value, which the
+*   				  map adopts instead of copying
+*   readMostlyMapRemove	- Removes a pair of (key,data) elements
+*/
+
+/** Type for defining the read mostly map */
+typedef struct ReadMostlyMap_t *ReadMostlyMap;
+
+/** Type for a reader of a read mostly map, owned by a single thread */
+typedef struct ReadMostlyMapReader_t *ReadMostlyMapReader;
+
+/**
+* readMostlyMapCreate: Allocates a new empty read mostly map. The parameters
+* are as in mapCreate.
+*
+* @return
+* 	NULL - if one of the parameters is NULL or allocations failed.
+* 	A new map in case of success.
+*/
+ReadMostlyMap readMostlyMapCreate(copyMapDataElements copyDataElement,
+                                  copyMapKeyElements copyKeyElement,
+                                  freeMapDataElements freeDataElement,
+                                  freeMapKeyElements freeKeyElement,
+                                  compareMapKeyElements compareKeyElements);
+
+/**
+* readMostlyMapDestroy: Deallocates an existing map, with all its versions and
+* readers. Must not be called while other threads still use the map.
+*
+* @param map - Target map to be deallocated. If map is NULL nothing will be
+* 		done
+*/
+void readMostlyMapDestroy(ReadMostlyMap map);
+
+/**
+* readMostlyMapRegisterReader: Creates a reader of the map for the calling
+* thread.
+*
+* @param map - The map to be read
+* @return
+* 	NULL if a NULL was sent or an allocation failed.
+* 	A new reader otherwise.
+*/
+ReadMostlyMapReader readMostlyMapRegisterReader(ReadMostlyMap map);
+
+/**
+* readMostlyMapUnregisterReader: Unregisters a reader and frees it. The reader
+* must not be in a read section.
+*
+* @param reader - The reader to unregister. If reader is NULL nothing will be
+* 		done
+*/
+void readMostlyMapUnregisterReader(ReadMostlyMapReader reader);
+
+/**
+* readMostlyMapReadBegin: Enters a read section and returns the current
+* version of the map. Neither the version nor the elements taken from it may
+* be used after readMostlyMapReadEnd.
+* The version must not be changed, and only mapGetSize, mapContains, mapGet
+* and the external iterators (mapIteratorBegin, MAP_ITERATE etc.) may be used
+* on it. Read sections must not be nested.
+*
+* @param reader - The reader of the calling thread
+* @return
+* 	NULL if a NULL was sent.
+* 	The current version of the map otherwise.
+*/
+Map readMostlyMapReadBegin(ReadMostlyMapReader reader);
+
+/**
+* readMostlyMapReadEnd: Leaves the read section of a reader.
+*
+* @param reader - The reader of the calling thread
+*/
+void readMostlyMapReadEnd(ReadMostlyMapReader reader);
+
+/**
+* readMostlyMapPut: Publishes a new version of the map in which the key is
+* paired with a copy of the data, as mapPut.
+*
+* @param map - The map to change
+* @param keyElement - The key element which need to be reassigned
+* @param dataElement - The new data element to associate with the given key.
+* @return
+* 	MAP_NULL_ARGUMENT if a NULL was sent as map or keyElement or dataElement
+* 	MAP_OUT_OF_MEMORY if an allocation failed, the map is left unchanged
+* 	MAP_SUCCESS the paired elements had been inserted successfully
+*/
+MapResult readMostlyMapPut(ReadMostlyMap map,
+                           MapKeyElement keyElement,
+                           MapDataElement dataElement);
+
+/**
+* readMostlyMapPutOwned: Publishes a new version of the map in which the key is
+* paired with the data, as mapPutOwned. The map adopts dataElement only if
+* MAP_SUCCESS is returned.
+*
+* @param map - The map to change
+* @param keyElement - The key element which need to be reassigned
+* @param dataElement - The new data element to associate with the given key.
+* @return
+* 	MAP_NULL_ARGUMENT if a NULL was sent as map or keyElement or dataElement
+* 	MAP_OUT_OF_MEMORY if an allocation failed, the map is left unchanged
+* 	MAP_SUCCESS the paired elements had been inserted successfully
+*/
+MapResult readMostlyMapPutOwned(ReadMostlyMap map,
+                                MapKeyElement keyElement,
+                                MapDataElement dataElement);
+
+/**
+* readMostlyMapRemove: Publishes a new version of the map without the key, as
+* mapRemove.
+*
+* @param map - The map to change
+* @param keyElement - The key element to find and remove from the map.
+* @return
+* 	MAP_NULL_ARGUMENT if a NULL was sent to the function
+* 	MAP_OUT_OF_MEMORY if an allocation failed, the map is left unchanged
+* 	MAP_ITEM_DOES_NOT_EXIST if an equal key item does not already exists in
+* 	the map
+* 	MAP_SUCCESS the paired elements had been removed successfully
+*/
+MapResult readMostlyMapRemove(ReadMostlyMap map, MapKeyElement keyElement);
+
+#endif /* READ_MOSTLY_MAP_H_ */
@@ -0,0 +1,129 @@
+#include "test_utilities.h"
+#include <stdlib.h>
+#include <string.h>
+#include "chessSystem.h"
+
+#define NUMBER_TESTS 3
+#define STATISTICS_PATH "tournament_statistics_test_output.txt"
+
+bool testChessAddGameAlreadyExists() {
+    ChessSystem chess = chessCreate();
+    ASSERT_TEST(chess != NULL);
+    ASSERT_TEST(chessAddTournament(chess, 1, 4, "London") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddTournament(chess, 2, 4, "Paris") == CHESS_SUCCESS);
+
+    ASSERT_TEST(chessAddGame(chess, 1, 1, 2, FIRST_PLAYER, 10) == CHESS_SUCCESS);
+    // the pair is the same pair in either order, and only within a tournament
+    ASSERT_TEST(chessAddGame(chess, 1, 1, 2, DRAW, 10) == CHESS_GAME_ALREADY_EXISTS);
+    ASSERT_TEST(chessAddGame(chess, 1, 2, 1, DRAW, 10) == CHESS_GAME_ALREADY_EXISTS);
+    ASSERT_TEST(chessAddGame(chess, 2, 2, 1, DRAW, 10) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(chess, 1, 1, 3, DRAW, 10) == CHESS_SUCCESS);
+
+    chessDestroy(chess);
+    return true;
+}
+
+bool testChessRemovePlayerReusedId() {
+    ChessSystem chess = chessCreate();
+    ASSERT_TEST(chess != NULL);
+    ASSERT_TEST(chessAddTournament(chess, 1, 4, "London") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddTournament(chess, 2, 4, "Paris") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(chess, 1, 1, 2, FIRST_PLAYER, 10) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(chess, 1, 3, 1, DRAW, 20) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(chess, 2, 1, 2, FIRST_PLAYER, 30) == CHESS_SUCCESS);
+    ASSERT_TEST(chessEndTournament(chess, 2) == CHESS_SUCCESS);
+
+    ASSERT_TEST(chessRemovePlayer(chess, 1) == CHESS_SUCCESS);
+    ASSERT_TEST(chessRemovePlayer(chess, 1) == CHESS_PLAYER_NOT_EXIST);
+
+    // a new player with the same id hasn't played anyone yet, once he is in
+    // the tournament his opponents must not remember the removed player either
+    ASSERT_TEST(chessAddGame(chess, 1, 1, 3, DRAW, 50) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(chess, 1, 2, 1, SECOND_PLAYER, 40) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(chess, 1, 3, 1, DRAW, 50) == CHESS_GAME_ALREADY_EXISTS);
+    // the ended tournament keeps its games, and takes no new ones
+    ASSERT_TEST(chessAddGame(chess, 2, 1, 2, DRAW, 60) == CHESS_TOURNAMENT_ENDED);
+
+    ChessResult result;
+    ASSERT_TEST(chessCalculateAveragePlayTime(chess, 1, &result) == 45);
+    ASSERT_TEST(result == CHESS_SUCCESS);
+    // player 2 keeps the games against the removed player
+    ASSERT_TEST(chessCalculateAveragePlayTime(chess, 2, &result) == 80.0 / 3);
+
+    ASSERT_TEST(chessEndTournament(chess, 1) == CHESS_SUCCESS);
+    ASSERT_TEST(chessRemovePlayer(chess, 1) == CHESS_SUCCESS);
+    ASSERT_TEST(chessRemoveTournament(chess, 1) == CHESS_SUCCESS);
+    ASSERT_TEST(chessCalculateAveragePlayTime(chess, 2, &result) == 30);
+
+    chessDestroy(chess);
+    return true;
+}
+
+bool testChessSaveTournamentStatistics() {
+    ChessSystem chess = chessCreate();
+    ASSERT_TEST(chess != NULL);
+    ASSERT_TEST(chessAddTournament(chess, 1, 4, "London") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddTournament(chess, 2, 4, "Paris") == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(chess, 1, 1, 2, FIRST_PLAYER, 2000) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(chess, 1, 1, 3, FIRST_PLAYER, 3000) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(chess, 1, 3, 2, SECOND_PLAYER, 3000) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(chess, 1, 4, 1, SECOND_PLAYER, 1000) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(chess, 1, 2, 4, FIRST_PLAYER, 3500) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(chess, 1, 3, 4, DRAW, 400) == CHESS_SUCCESS);
+    ASSERT_TEST(chessAddGame(chess, 2, 1, 2, DRAW, 100) == CHESS_SUCCESS);
+    ASSERT_TEST(chessSaveTournamentStatistics(chess, STATISTICS_PATH) ==
+                CHESS_NO_TOURNAMENTS_ENDED);
+
+    // only the ended tournament is printed
+    ASSERT_TEST(chessEndTournament(chess, 1) == CHESS_SUCCESS);
+    ASSERT_TEST(chessSaveTournamentStatistics(chess, STATISTICS_PATH) ==
+                CHESS_SUCCESS);
+    ASSERT_TEST(chessSaveTournamentStatistics(NULL, STATISTICS_PATH) ==
+                CHESS_NULL_ARGUMENT);
+
+    char statistics[100] = {0};
+    FILE *file = fopen(STATISTICS_PATH, "r");
+    ASSERT_TEST(file != NULL);
+    fread(statistics, 1, sizeof(statistics) - 1, file);
+    fclose(file);
+    remove(STATISTICS_PATH);
+    ASSERT_TEST(strcmp(statistics, "1\n3500\n2150.00\nLondon\n6\n4\n") == 0);
+
+    chessDestroy(chess);
+    return true;
+}
+
+bool (*tests[]) (void) = {
+        testChessAddGameAlreadyExists,
+        testChessRemovePlayerReusedId,
+        testChessSaveTournamentStatistics
+};
+
+/*The names of the test functions should be added here*/
+const char* testNames[] = {
+        "testChessAddGameAlreadyExists",
+        "testChessRemovePlayerReusedId",
+        "testChessSaveTournamentStatistics"
+};
+
+int main(int argc, char *argv[]) {
+    if (argc == 1) {
+        for (int test_idx = 0; test_idx < NUMBER_TESTS; test_idx++) {
+            RUN_TEST(tests[test_idx], testNames[test_idx]);
+        }
+        return 0;
+    }
+    if (argc != 2) {
+        fprintf(stdout, "Usage: <your_executable_file_name> <test index>\n");
+        return 0;
+    }
+
+    int test_idx = strtol(argv[1], NULL, 10);
+    if (test_idx < 1 || test_idx > NUMBER_TESTS) {
+        fprintf(stderr, "Invalid test index %d\n", test_idx);
+        return 0;
+    }
+
+    RUN_TEST(tests[test_idx - 1], testNames[test_idx - 1]);
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include "test_utilities.h"
+#include <stdlib.h>
+#include <pthread.h>
+#include "concurrent_map.h"
+
+#define NUMBER_TESTS 2
+#define NUMBER_THREADS 4
+#define KEYS_PER_THREAD 10000
+
+/** Function to be used for copying an int as a data to the map */
+static MapDataElement copyDataInt(MapDataElement n) {
+    if (!n) {
+        return NULL;
+    }
+    int *copy = malloc(sizeof(*copy));
+    if (!copy) {
+        return NULL;
+    }
+    *copy = *(int *) n;
+    return copy;
+}
+
+/** Function to be used by the map for freeing elements */
+static void freeInt(MapDataElement n) {
+    free(n);
+}
+
+/** Arguments of a thread filling the map */
+typedef struct {
+    ConcurrentMap map;
+    int first;
+} Ingestion;
+
+/** Thread inserting its own keys, reading them back and removing every odd one */
+static void *ingest(void *argument) {
+    Ingestion *ingestion = argument;
+    for (int i = ingestion->first; i < ingestion->first + KEYS_PER_THREAD; ++i) {
+        if (concurrentMapPut(ingestion->map, &i, &i) != MAP_SUCCESS) {
+            return NULL;
+        }
+    }
+    for (int i = ingestion->first; i < ingestion->first + KEYS_PER_THREAD; ++i) {
+        int *data = concurrentMapGet(ingestion->map, &i);
+        if (!data || *data != i) {
+            free(data);
+            return NULL;
+        }
+        free(data);
+        if (i % 2 && concurrentMapRemove(ingestion->map, &i) != MAP_SUCCESS) {
+            return NULL;
+        }
+    }
+    return ingestion;
+}
+
+/** Sums the keys of the map, checking every data equals its key */
+static bool sumKeys(MapKeyElement key, MapDataElement data, void *context) {
+    if (*(int *) key != *(int *) data) {
+        return false;
+    }
+    *(long *) context += *(int *) key;
+    return true;
+}
+
+bool testConcurrentMapIntKeyed() {
+    ConcurrentMap map = concurrentMapCreateIntKeyed(8, copyDataInt, freeInt);
+    ASSERT_TEST(map != NULL);
+    ASSERT_TEST(concurrentMapGetSize(map) == 0);
+
+    int key = 7, data = 70;
+    ASSERT_TEST(concurrentMapPut(map, &key, &data) == MAP_SUCCESS);
+    ASSERT_TEST(concurrentMapContains(map, &key));
+    int *taken = concurrentMapTake(map, &key);
+    ASSERT_TEST(taken && *taken == 70);
+    ASSERT_TEST(concurrentMapPutOwned(map, &key, taken) == MAP_SUCCESS);
+    ASSERT_TEST(concurrentMapGetSize(map) == 1);
+    ASSERT_TEST(concurrentMapRemove(map, &key) == MAP_SUCCESS);
+    ASSERT_TEST(concurrentMapRemove(map, &key) == MAP_ITEM_DOES_NOT_EXIST);
+    ASSERT_TEST(concurrentMapGet(map, &key) == NULL);
+
+    concurrentMapDestroy(map);
+    return true;
+}
+
+bool testConcurrentMapThreads() {
+    ConcurrentMap map = concurrentMapCreateIntKeyed(8, copyDataInt, freeInt);
+    pthread_t threads[NUMBER_THREADS];
+    Ingestion ingestions[NUMBER_THREADS];
+
+    for (int i = 0; i < NUMBER_THREADS; ++i) {
+        ingestions[i].map = map;
+        ingestions[i].first = i * KEYS_PER_THREAD;
+        ASSERT_TEST(pthread_create(&threads[i], NULL, ingest,
+                                   &ingestions[i]) == 0);
+    }
+    for (int i = 0; i < NUMBER_THREADS; ++i) {
+        void *result;
+        ASSERT_TEST(pthread_join(threads[i], &result) == 0);
+        ASSERT_TEST(result == &ingestions[i]);
+    }
+
+    int total = NUMBER_THREADS * KEYS_PER_THREAD;
+    ASSERT_TEST(concurrentMapGetSize(map) == total / 2);
+
+    long sum = 0;
+    ASSERT_TEST(concurrentMapForEach(map, sumKeys, &sum) == MAP_SUCCESS);
+    ASSERT_TEST(sum == (long) (total / 2) * (total / 2 - 1));
+
+    ASSERT_TEST(concurrentMapClear(map) == MAP_SUCCESS);
+    ASSERT_TEST(concurrentMapGetSize(map) == 0);
+    concurrentMapDestroy(map);
+    return true;
+}
+
+bool (*tests[]) (void) = {
+        testConcurrentMapIntKeyed,
+        testConcurrentMapThreads
+};
+
+/*The names of the test functions should be added here*/
+const char* testNames[] = {
+        "testConcurrentMapIntKeyed",
+        "testConcurrentMapThreads"
+};
+
+int main(int argc, char *argv[]) {
+    if (argc == 1) {
+        for (int test_idx = 0; test_idx < NUMBER_TESTS; test_idx++) {
+            RUN_TEST(tests[test_idx], testNames[test_idx]);
+        }
+        return 0;
+    }
+    if (argc != 2) {
+        fprintf(stdout, "Usage: <your_executable_file_name> <test index>\n");
+        return 0;
+    }
+
+    int test_idx = strtol(argv[1], NULL, 10);
+    if (test_idx < 1 || test_idx > NUMBER_TESTS) {
+        fprintf(stderr, "Invalid test index %d\n", test_idx);
+        return 0;
+    }
+
+    RUN_TEST(tests[test_idx - 1], testNames[test_idx - 1]);
+    return 0;
+}
@@ -2,7 +2,7 @@
 #include <stdlib.h>
 #include "map.h"
 
-#define NUMBER_TESTS 4
+#define NUMBER_TESTS 16
 
 /** Function to be used for copying an int as a key to the map */
 static MapKeyElement copyKeyInt(MapKeyElement n) {
@@ -45,6 +45,8 @@ static int compareInts(MapKeyElement n1, MapKeyElement n2) {
     return (*(int *) n1 - *(int *) n2);
 }
 
+MAP_DEFINE(IntCharMap, int, char, MAP_COMPARE_VALUES)
+
 bool testMapCreateDestroy() {
     Map map = mapCreate(copyDataChar, copyKeyInt, freeChar, freeInt,
                         compareInts);
@@ -124,12 +126,518 @@ bool testIterator() {
     return true;
 }
 
+bool testMapIntKeyed() {
+    Map map = mapCreateIntKeyed(copyDataChar, freeChar);
+    ASSERT_TEST(map != NULL);
+    for (int i = 999; i > 0; i -= 2) {
+        char j = (char) i;
+        ASSERT_TEST(mapPut(map, &i, &j) == MAP_SUCCESS);
+    }
+    ASSERT_TEST(mapGetSize(map) == 500);
+
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TEST(mapContains(map, &i) == (i % 2 == 1));
+    }
+    for (int i = 1; i < 1000; i += 4) {
+        ASSERT_TEST(mapRemove(map, &i) == MAP_SUCCESS);
+    }
+    int i = 1;
+    ASSERT_TEST(mapGet(map, &i) == NULL);
+    i = 3;
+    ASSERT_TEST(*(char *) mapGet(map, &i) == (char) 3);
+
+    i = 3;
+    MAP_FOREACH(int *, iter, map) {
+        ASSERT_TEST(*iter == i);
+        freeInt(iter);
+        i += 4;
+    }
+
+    mapDestroy(map);
+    return true;
+}
+
+bool testMapPutOwnedAndTake() {
+    Map map = mapCreate(copyDataChar, copyKeyInt, freeChar, freeInt,
+                        compareInts);
+    int key = 7;
+    char *data = copyDataChar(&(char){'x'});
+    ASSERT_TEST(mapPutOwned(map, &key, data) == MAP_SUCCESS);
+    ASSERT_TEST(mapGet(map, &key) == data);
+
+    char *taken = mapTake(map, &key);
+    ASSERT_TEST(taken == data);
+    ASSERT_TEST(mapGetSize(map) == 0);
+    ASSERT_TEST(mapTake(map, &key) == NULL);
+    freeChar(taken);
+
+    mapDestroy(map);
+    return true;
+}
+
+bool testMapIterate() {
+    Map map = mapCreate(copyDataChar, copyKeyInt, freeChar, freeInt,
+                        compareInts);
+    for (int i = 100; i > 0; --i) {
+        char j = (char) i;
+        ASSERT_TEST(mapPut(map, &i, &j) == MAP_SUCCESS);
+    }
+
+    int i = 1, pairs = 0;
+    MAP_ITERATE(outer, map) {
+        ASSERT_TEST(*(int *) mapIteratorKey(&outer) == i);
+        ASSERT_TEST(*(char *) mapIteratorData(&outer) == (char) i);
+        MAP_ITERATE(inner, map) {
+            if (*(int *) mapIteratorKey(&inner) < i) {
+                pairs++;
+            }
+        }
+        i++;
+    }
+    ASSERT_TEST(i == 101);
+    ASSERT_TEST(pairs == 100 * 99 / 2);
+
+    mapDestroy(map);
+    return true;
+}
+
+bool testMapPutBatchAndCopy() {
+    Map map = mapCreate(copyDataChar, copyKeyInt, freeChar, freeInt,
+                        compareInts);
+    int keys[1000];
+    char data[1000];
+    MapKeyElement key_elements[1000];
+    MapDataElement data_elements[1000];
+    for (int i = 0; i < 1000; ++i) {
+        keys[i] = 2 * i;
+        data[i] = (char) i;
+        key_elements[i] = &keys[i];
+        data_elements[i] = &data[i];
+    }
+    ASSERT_TEST(mapPutBatch(map, key_elements, data_elements, 1000) == MAP_SUCCESS);
+    ASSERT_TEST(mapGetSize(map) == 1000);
+
+    Map copy = mapCopy(map);
+    mapDestroy(map);
+    ASSERT_TEST(copy != NULL);
+    ASSERT_TEST(mapGetSize(copy) == 1000);
+    int i = 0;
+    MAP_ITERATE(iterator, copy) {
+        ASSERT_TEST(*(int *) mapIteratorKey(&iterator) == 2 * i);
+        ASSERT_TEST(*(char *) mapIteratorData(&iterator) == (char) i);
+        i++;
+    }
+
+    key_elements[0] = &keys[1];
+    key_elements[1] = &keys[0];
+    ASSERT_TEST(mapPutBatch(copy, key_elements, data_elements, 2) == MAP_ERROR);
+
+    mapDestroy(copy);
+    return true;
+}
+
+bool testMapPersistentCopy() {
+    Map map = mapCreatePersistent(copyDataChar, copyKeyInt, freeChar, freeInt,
+                                  compareInts);
+    for (int i = 0; i < 1000; ++i) {
+        char j = 'a';
+        ASSERT_TEST(mapPut(map, &i, &j) == MAP_SUCCESS);
+    }
+
+    Map snapshot = mapCopy(map);
+    ASSERT_TEST(snapshot != NULL);
+    for (int i = 0; i < 1000; i += 2) {
+        char j = 'b';
+        ASSERT_TEST(mapPut(map, &i, &j) == MAP_SUCCESS);
+    }
+    for (int i = 1; i < 1000; i += 2) {
+        ASSERT_TEST(mapRemove(map, &i) == MAP_SUCCESS);
+    }
+
+    ASSERT_TEST(mapGetSize(map) == 500);
+    ASSERT_TEST(mapGetSize(snapshot) == 1000);
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TEST(*(char *) mapGet(snapshot, &i) == 'a');
+    }
+    mapDestroy(snapshot);
+
+    int i = 0;
+    ASSERT_TEST(*(char *) mapGet(map, &i) == 'b');
+    mapDestroy(map);
+    return true;
+}
+
 /*The functions for the tests should be added here*/
+bool testMapRange() {
+    Map map = mapCreate(copyDataChar, copyKeyInt, freeChar, freeInt,
+                        compareInts);
+    for (int i = 2; i <= 2000; i += 2) {
+        char j = (char) i;
+        ASSERT_TEST(mapPut(map, &i, &j) == MAP_SUCCESS);
+    }
+
+    int low = 101, high = 1500;
+    MapIterator iterator = mapLowerBound(map, &low);
+    ASSERT_TEST(*(int *) mapIteratorKey(&iterator) == 102);
+
+    int expected = 102;
+    MAP_ITERATE_RANGE(range, map, &low, &high) {
+        ASSERT_TEST(*(int *) mapIteratorKey(&range) == expected);
+        expected += 2;
+    }
+    ASSERT_TEST(expected == 1502);
+
+    low = 2001;
+    iterator = mapLowerBound(map, &low);
+    ASSERT_TEST(!mapIteratorValid(&iterator));
+    low = 5, high = 5;
+    iterator = mapGetRange(map, &low, &high);
+    ASSERT_TEST(!mapIteratorValid(&iterator));
+
+    mapDestroy(map);
+    return true;
+}
+
+bool testMapDefine() {
+    IntCharMap map = IntCharMapCreate();
+    ASSERT_TEST(map != NULL);
+    for (int i = 1000; i > 0; --i) {
+        ASSERT_TEST(IntCharMapPut(map, i, (char) i) == MAP_SUCCESS);
+    }
+    ASSERT_TEST(IntCharMapGetSize(map) == 1000);
+    ASSERT_TEST(*IntCharMapGet(map, 77) == (char) 77);
+    ASSERT_TEST(IntCharMapGet(map, 1001) == NULL);
+
+    for (int i = 2; i <= 1000; i += 2) {
+        ASSERT_TEST(IntCharMapRemove(map, i) == MAP_SUCCESS);
+    }
+    ASSERT_TEST(IntCharMapRemove(map, 2) == MAP_ITEM_DOES_NOT_EXIST);
+    ASSERT_TEST(!IntCharMapContains(map, 500));
+
+    int expected = 1;
+    for (IntCharMapIterator iterator = IntCharMapIteratorBegin(map);
+         IntCharMapIteratorValid(&iterator);
+         IntCharMapIteratorNext(&iterator)) {
+        ASSERT_TEST(IntCharMapIteratorKey(&iterator) == expected);
+        ASSERT_TEST(*IntCharMapIteratorData(&iterator) == (char) expected);
+        expected += 2;
+    }
+    ASSERT_TEST(expected == 1001);
+
+    IntCharMapDestroy(map);
+    return true;
+}
+
+bool testMapStats() {
+    Map map = mapCreateIntKeyed(copyDataChar, freeChar);
+    MapStats stats;
+    ASSERT_TEST(mapGetStats(map, &stats) == MAP_SUCCESS);
+    ASSERT_TEST(stats.finds == 0 && stats.allocations == 0);
+
+    for (int i = 0; i < 100; ++i) {
+        char j = (char) i;
+        ASSERT_TEST(mapPut(map, &i, &j) == MAP_SUCCESS);
+    }
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_TEST(*(char *) mapGet(map, &i) == (char) i);
+    }
+    MAP_ITERATE(iterator, map) {
+    }
+
+    ASSERT_TEST(mapGetStats(map, &stats) == MAP_SUCCESS);
+#ifdef MAP_STATS
+    ASSERT_TEST(stats.finds == 200);
+    ASSERT_TEST(stats.nodes_visited >= 100 && stats.comparisons >= 100);
+    ASSERT_TEST(stats.index_probes >= 100);
+    ASSERT_TEST(stats.allocations > 100);
+    ASSERT_TEST(stats.iterator_steps >= 100);
+#else
+    ASSERT_TEST(stats.finds == 0 && stats.iterator_steps == 0);
+#endif
+
+    ASSERT_TEST(mapResetStats(map) == MAP_SUCCESS);
+    ASSERT_TEST(mapGetStats(map, &stats) == MAP_SUCCESS);
+    ASSERT_TEST(stats.finds == 0 && stats.comparisons == 0);
+    ASSERT_TEST(mapGetStats(NULL, &stats) == MAP_NULL_ARGUMENT);
+
+    mapDestroy(map);
+    return true;
+}
+
+/** Encodes a char data element as a single byte */
+static int encodeChar(MapDataElement n, unsigned char *buffer, int size) {
+    if (size >= 1) {
+        buffer[0] = (unsigned char) *(char *) n;
+    }
+    return 1;
+}
+
+/** Decodes a char data element written by encodeChar */
+static MapDataElement decodeChar(const unsigned char *buffer, int size) {
+    if (size != 1) {
+        return NULL;
+    }
+    char c = (char) buffer[0];
+    return copyDataChar(&c);
+}
+
+bool testMapSerialize() {
+    Map map = mapCreate(copyDataChar, copyKeyInt, freeChar, freeInt,
+                        compareInts);
+    for (int i = -500; i < 500; ++i) {
+        char j = (char) i;
+        ASSERT_TEST(mapPut(map, &i, &j) == MAP_SUCCESS);
+    }
+
+    FILE *stream = tmpfile();
+    ASSERT_TEST(stream != NULL);
+    ASSERT_TEST(mapSerialize(map, stream, mapEncodeInt, encodeChar) ==
+                MAP_SUCCESS);
+    rewind(stream);
+
+    Map loaded = mapCreateIntKeyed(copyDataChar, freeChar);
+    ASSERT_TEST(mapDeserialize(loaded, stream, mapDecodeInt, decodeChar) ==
+                MAP_SUCCESS);
+    ASSERT_TEST(mapGetSize(loaded) == 1000);
+    for (int i = -500; i < 500; ++i) {
+        ASSERT_TEST(*(char *) mapGet(loaded, &i) == (char) i);
+    }
+
+    // a stream which is not a serialized map leaves the map empty
+    rewind(stream);
+    fputs("not a map", stream);
+    rewind(stream);
+    ASSERT_TEST(mapDeserialize(loaded, stream, mapDecodeInt, decodeChar) ==
+                MAP_ERROR);
+    ASSERT_TEST(mapGetSize(loaded) == 0);
+
+    fclose(stream);
+    mapDestroy(loaded);
+    mapDestroy(map);
+    return true;
+}
+
+/** Makes the data element of a missing key, counting its calls in context */
+static MapDataElement createChar(MapKeyElement n, void *context) {
+    ++*(int *) context;
+    char c = (char) *(int *) n;
+    return copyDataChar(&c);
+}
+
+/** Fails to make a data element, as on memory allocation error */
+static MapDataElement createNothing(MapKeyElement n, void *context) {
+    (void) n;
+    ++*(int *) context;
+    return NULL;
+}
+
+bool testMapGetOrInsert() {
+    Map maps[] = {mapCreate(copyDataChar, copyKeyInt, freeChar, freeInt,
+                            compareInts),
+                  mapCreateIntKeyed(copyDataChar, freeChar)};
+    for (int m = 0; m < 2; ++m) {
+        Map map = maps[m];
+        int created = 0;
+        int missing = 7;
+        ASSERT_TEST(mapGetOrInsert(map, &missing, createNothing, &created) ==
+                    NULL);
+        ASSERT_TEST(created == 1 && mapGetSize(map) == 0);
+        ASSERT_TEST(mapGetFirst(map) == NULL);
+        MAP_ITERATE(iterator, map) {
+            ASSERT_TEST(false);
+        }
+        created = 0;
+
+        for (int i = 0; i < 200; ++i) {
+            char *data = mapGetOrInsert(map, &i, createChar, &created);
+            ASSERT_TEST(data != NULL && *data == (char) i);
+        }
+        ASSERT_TEST(created == 200 && mapGetSize(map) == 200);
+
+        for (int i = 0; i < 200; ++i) {
+            char *data = mapGetOrInsert(map, &i, createChar, &created);
+            ASSERT_TEST(data == mapGet(map, &i));
+        }
+        ASSERT_TEST(created == 200);
+
+        MapDataElement data;
+        int key = 50;
+        ASSERT_TEST(mapTryInsert(map, &key, createChar, &created, &data) ==
+                    MAP_ITEM_ALREADY_EXISTS);
+        ASSERT_TEST(data == mapGet(map, &key) && created == 200);
+        key = 1000;
+        ASSERT_TEST(mapTryInsert(map, &key, createChar, &created, &data) ==
+                    MAP_SUCCESS);
+        ASSERT_TEST(data == mapGet(map, &key) && created == 201);
+        ASSERT_TEST(mapGetSize(map) == 201);
+        ASSERT_TEST(mapTryInsert(map, &key, NULL, NULL, &data) ==
+                    MAP_NULL_ARGUMENT);
+        ASSERT_TEST(mapGetOrInsert(NULL, &key, createChar, &created) == NULL);
+
+        mapDestroy(map);
+    }
+
+    // hits leave the nodes shared with a copy of a persistent map as they are
+    Map map = mapCreatePersistent(copyDataChar, copyKeyInt, freeChar, freeInt,
+                                  compareInts);
+    int created = 0;
+    for (int i = 0; i < 200; ++i) {
+        ASSERT_TEST(mapGetOrInsert(map, &i, createChar, &created) != NULL);
+    }
+    Map snapshot = mapCopy(map);
+    ASSERT_TEST(snapshot != NULL);
+    ASSERT_TEST(mapResetStats(map) == MAP_SUCCESS);
+    for (int i = 0; i < 200; ++i) {
+        ASSERT_TEST(mapGetOrInsert(map, &i, createChar, &created) ==
+                    mapGet(snapshot, &i));
+    }
+    MapStats stats;
+    ASSERT_TEST(mapGetStats(map, &stats) == MAP_SUCCESS);
+    ASSERT_TEST(stats.allocations == 0 && created == 200);
+
+    // an overwrite copies the path, the copy keeps its data element
+    int key = 100;
+    char c = 'x';
+    ASSERT_TEST(mapPut(map, &key, &c) == MAP_SUCCESS);
+    ASSERT_TEST(*(char *) mapGet(map, &key) == 'x');
+    ASSERT_TEST(*(char *) mapGet(snapshot, &key) == (char) key);
+
+    mapDestroy(snapshot);
+    mapDestroy(map);
+    return true;
+}
+
+/** Merges two char data elements into their sum */
+static MapDataElement addChars(MapKeyElement n, MapDataElement first,
+                               MapDataElement second) {
+    (void) n;
+    char sum = (char) (*(char *) first + *(char *) second);
+    return copyDataChar(&sum);
+}
+
+bool testMapMerge() {
+    Map maps[] = {mapCreate(copyDataChar, copyKeyInt, freeChar, freeInt,
+                            compareInts),
+                  mapCreateIntKeyed(copyDataChar, freeChar),
+                  mapCreatePersistent(copyDataChar, copyKeyInt, freeChar,
+                                      freeInt, compareInts)};
+    for (int m = 0; m < 3; ++m) {
+        Map map = maps[m];
+        Map other = mapCreate(copyDataChar, copyKeyInt, freeChar, freeInt,
+                              compareInts);
+        // map holds the even keys below 200, other every third key below 300
+        for (int i = 0; i < 300; ++i) {
+            char j = 1;
+            if (i % 2 == 0 && i < 200) {
+                ASSERT_TEST(mapPut(map, &i, &j) == MAP_SUCCESS);
+            }
+            if (i % 3 == 0) {
+                ASSERT_TEST(mapPut(other, &i, &j) == MAP_SUCCESS);
+            }
+        }
+        Map snapshot = mapCopy(map);
+
+        Map united = mapUnion(map, other, NULL);
+        ASSERT_TEST(mapMerge(map, other, addChars) == MAP_SUCCESS);
+        ASSERT_TEST(mapGetSize(map) == 100 + 100 - 34);
+        ASSERT_TEST(mapGetSize(united) == mapGetSize(map));
+        ASSERT_TEST(mapGetSize(other) == 100 && mapGetSize(snapshot) == 100);
+        for (int i = 0; i < 300; ++i) {
+            bool in_map = i % 2 == 0 && i < 200, in_other = i % 3 == 0;
+            char *data = mapGet(map, &i);
+            ASSERT_TEST((data != NULL) == (in_map || in_other));
+            if (data != NULL) {
+                ASSERT_TEST(*data == (in_map && in_other ? 2 : 1));
+                ASSERT_TEST(*(char *) mapGet(united, &i) == 1);
+            }
+        }
+        int previous = -1;
+        MAP_ITERATE(iterator, map) {
+            ASSERT_TEST(*(int *) mapIteratorKey(&iterator) > previous);
+            previous = *(int *) mapIteratorKey(&iterator);
+        }
+
+        ASSERT_TEST(mapMerge(map, NULL, NULL) == MAP_NULL_ARGUMENT);
+        ASSERT_TEST(mapUnion(NULL, other, NULL) == NULL);
+
+        mapDestroy(united);
+        mapDestroy(snapshot);
+        mapDestroy(other);
+        mapDestroy(map);
+    }
+    return true;
+}
+
+/** Matches the keys divisible by the int in context */
+static bool isDivisible(MapKeyElement n, MapDataElement data, void *context) {
+    (void) data;
+    return *(int *) n % *(int *) context == 0;
+}
+
+bool testMapRemoveIf() {
+    Map maps[] = {mapCreate(copyDataChar, copyKeyInt, freeChar, freeInt,
+                            compareInts),
+                  mapCreateIntKeyed(copyDataChar, freeChar),
+                  mapCreatePersistent(copyDataChar, copyKeyInt, freeChar,
+                                      freeInt, compareInts)};
+    for (int m = 0; m < 3; ++m) {
+        Map map = maps[m];
+        for (int i = 0; i < 1000; ++i) {
+            char j = (char) i;
+            ASSERT_TEST(mapPut(map, &i, &j) == MAP_SUCCESS);
+        }
+        Map snapshot = mapCopy(map);
+        int one = 1;
+        MapDataElement first_kept = mapGet(map, &one);
+
+        int divisor = 3;
+        ASSERT_TEST(mapRemoveIf(map, isDivisible, &divisor) == MAP_SUCCESS);
+        ASSERT_TEST(mapGetSize(map) == 666 && mapGetSize(snapshot) == 1000);
+        // kept data elements of a map which isn't persistent are moved
+        ASSERT_TEST((m == 2) || (mapGet(map, &one) == first_kept));
+        for (int i = 0; i < 1000; ++i) {
+            ASSERT_TEST(mapContains(map, &i) == (i % 3 != 0));
+            ASSERT_TEST(*(char *) mapGet(snapshot, &i) == (char) i);
+        }
+        int previous = -1;
+        MAP_ITERATE(iterator, map) {
+            int key = *(int *) mapIteratorKey(&iterator);
+            ASSERT_TEST(key > previous);
+            ASSERT_TEST(*(char *) mapIteratorData(&iterator) == (char) key);
+            previous = key;
+        }
+
+        divisor = 1000;
+        ASSERT_TEST(mapRemoveIf(map, isDivisible, &divisor) == MAP_SUCCESS);
+        ASSERT_TEST(mapGetSize(map) == 666);
+        divisor = 1;
+        ASSERT_TEST(mapRemoveIf(map, isDivisible, &divisor) == MAP_SUCCESS);
+        ASSERT_TEST(mapGetSize(map) == 0 && mapGetFirst(map) == NULL);
+        ASSERT_TEST(mapRemoveIf(map, NULL, NULL) == MAP_NULL_ARGUMENT);
+
+        mapDestroy(snapshot);
+        mapDestroy(map);
+    }
+    return true;
+}
+
 bool (*tests[]) (void) = {
         testMapCreateDestroy,
         testMapAddAndSize,
         testMapGet,
-        testIterator
+        testIterator,
+        testMapIntKeyed,
+        testMapPutOwnedAndTake,
+        testMapIterate,
+        testMapPutBatchAndCopy,
+        testMapPersistentCopy,
+        testMapRange,
+        testMapDefine,
+        testMapStats,
+        testMapSerialize,
+        testMapGetOrInsert,
+        testMapMerge,
+        testMapRemoveIf
 };
 
 /*The names of the test functions should be added here*/
@@ -137,7 +645,19 @@ const char* testNames[] = {
         "testMapCreateDestroy",
         "testMapAddAndSize",
         "testMapGet",
-        "testIterator"
+        "testIterator",
+        "testMapIntKeyed",
+        "testMapPutOwnedAndTake",
+        "testMapIterate",
+        "testMapPutBatchAndCopy",
+        "testMapPersistentCopy",
+        "testMapRange",
+        "testMapDefine",
+        "testMapStats",
+        "testMapSerialize",
+        "testMapGetOrInsert",
+        "testMapMerge",
+        "testMapRemoveIf"
 };
 
 
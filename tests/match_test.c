@@ -0,0 +1,125 @@
+#include "test_utilities.h"
+#include <stdlib.h>
+#include "match.h"
+#include "tournament.h"
+#include "player.h"
+
+#define NUMBER_TESTS 2
+#define NUMBER_MATCHES 40
+
+bool testMatchArenaReuse() {
+    Tournament tournament = tournamentCreate(1, "London", 1);
+    Player first = playerCreate(1);
+    Player second = playerCreate(2);
+    ASSERT_TEST_WITH_FREE(tournament && first && second,
+        (tournamentDestroy(tournament), playerDestroy(first, false),
+         playerDestroy(second, false)));
+
+    // more matches than the first blocks of the arena hold
+    Match matches[NUMBER_MATCHES];
+    for (int i = 0; i < NUMBER_MATCHES; i++) {
+        matches[i] = matchCreate(first, second, first, tournament, i);
+        ASSERT_TEST_WITH_FREE(matches[i] != NULL,
+            (tournamentDestroy(tournament), playerDestroy(first, false),
+             playerDestroy(second, false)));
+    }
+
+    // destroyed matches are handed out again, the last destroyed first
+    matchDestroy(matches[3]);
+    matchDestroy(matches[30]);
+    Match reused = matchCreate(second, first, NULL, tournament, 100);
+    Match reused_again = matchCreate(first, second, second, tournament, 200);
+    ASSERT_TEST_WITH_FREE(reused == matches[30] && reused_again == matches[3],
+        (tournamentDestroy(tournament), playerDestroy(first, false),
+         playerDestroy(second, false)));
+
+    // a reused match keeps nothing of the destroyed one
+    Player winner;
+    ASSERT_TEST_WITH_FREE(matchGetFirst(reused) == second &&
+                          matchGetSecond(reused) == first &&
+                          matchGetDuration(reused) == 100 &&
+                          matchGetWinner(reused, &winner) == CHESS_SUCCESS &&
+                          winner == NULL &&
+                          *matchGetHook(reused, MATCH_HOOK_SYSTEM, NULL) == -1 &&
+                          *matchGetHook(reused, MATCH_HOOK_PLAYER, first) == -1,
+        (tournamentDestroy(tournament), playerDestroy(first, false),
+         playerDestroy(second, false)));
+
+    // the arena is empty again, so new matches are carved out of the blocks
+    Match fresh = matchCreate(first, second, NULL, tournament, 300);
+    ASSERT_TEST_WITH_FREE(fresh != NULL && fresh != matches[3] &&
+                          fresh != matches[30],
+        (tournamentDestroy(tournament), playerDestroy(first, false),
+         playerDestroy(second, false)));
+    ASSERT_TEST_WITH_FREE(matchGetDuration(matches[29]) == 29 &&
+                          matchGetDuration(matches[31]) == 31,
+        (tournamentDestroy(tournament), playerDestroy(first, false),
+         playerDestroy(second, false)));
+
+    // the matches which weren't destroyed are freed with the tournament
+    tournamentDestroy(tournament);
+    playerDestroy(first, false);
+    playerDestroy(second, false);
+    return true;
+}
+
+bool testMatchCopyInArena() {
+    Tournament tournament = tournamentCreate(1, "London", 1);
+    Player first = playerCreate(1);
+    Player second = playerCreate(2);
+    ASSERT_TEST_WITH_FREE(tournament && first && second,
+        (tournamentDestroy(tournament), playerDestroy(first, false),
+         playerDestroy(second, false)));
+
+    Match match = matchCreate(first, second, second, tournament, 60);
+    Match copy = matchCopy(match);
+    ASSERT_TEST_WITH_FREE(match && copy && copy != match &&
+                          matchCompare(match, copy) == 0 &&
+                          matchGetTournament(copy) == tournament,
+        (tournamentDestroy(tournament), playerDestroy(first, false),
+         playerDestroy(second, false)));
+
+    // the copy's memory goes back to the same arena
+    matchDestroy(copy);
+    ASSERT_TEST_WITH_FREE(matchCreate(first, second, NULL, tournament, 1) == copy,
+        (tournamentDestroy(tournament), playerDestroy(first, false),
+         playerDestroy(second, false)));
+
+    tournamentDestroy(tournament);
+    playerDestroy(first, false);
+    playerDestroy(second, false);
+    return true;
+}
+
+bool (*tests[]) (void) = {
+        testMatchArenaReuse,
+        testMatchCopyInArena
+};
+
+/*The names of the test functions should be added here*/
+const char* testNames[] = {
+        "testMatchArenaReuse",
+        "testMatchCopyInArena"
+};
+
+int main(int argc, char *argv[]) {
+    if (argc == 1) {
+        for (int test_idx = 0; test_idx < NUMBER_TESTS; test_idx++) {
+            RUN_TEST(tests[test_idx], testNames[test_idx]);
+        }
+        return 0;
+    }
+    if (argc != 2) {
+        fprintf(stdout, "Usage: <your_executable_file_name> <test index>\n");
+        return 0;
+    }
+
+    int test_idx = strtol(argv[1], NULL, 10);
+    if (test_idx < 1 || test_idx > NUMBER_TESTS) {
+        fprintf(stderr, "Invalid test index %d\n", test_idx);
+        return 0;
+    }
+
+    RUN_TEST(tests[test_idx - 1], testNames[test_idx - 1]);
+    return 0;
+}
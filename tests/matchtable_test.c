@@ -0,0 +1,183 @@
+#include "test_utilities.h"
+#include <stdlib.h>
+#include "matchtable.h"
+#include "tournament.h"
+#include "player.h"
+
+/**
+ * The kernels are picked when matchtable.c is compiled, so this test should be
+ * built and run three times: as is, with -msse4.1 and with -mavx2. Every
+ * build checks the table against plain loops over the same matches, for sizes
+ * which leave the vector loops with a remainder.
+ */
+
+#define NUMBER_TESTS 3
+#define NUMBER_PLAYERS 5
+#define MAX_SIZE 40
+
+/** The matches of a table, with everything needed to build and check it */
+typedef struct table_matches_t {
+    Tournament tournament;
+    Player players[NUMBER_PLAYERS];
+    MatchVector matches;
+    int first_ids[MAX_SIZE];
+    int second_ids[MAX_SIZE];
+    Winner results[MAX_SIZE];
+    int durations[MAX_SIZE];
+} TableMatches;
+
+static void destroyTableMatches(TableMatches *matches) {
+    matchVectorDestroy(matches->matches, false);
+    tournamentDestroy(matches->tournament);
+    for (int i = 0; i < NUMBER_PLAYERS; i++) {
+        playerDestroy(matches->players[i], false);
+    }
+}
+
+/** Creates size matches between changing pairs, with changing results */
+static bool createTableMatches(TableMatches *matches, int size) {
+    matches->tournament = tournamentCreate(1, "London", MAX_SIZE);
+    matches->matches = matchVectorCreate(MATCH_HOOK_NONE, NULL);
+    for (int i = 0; i < NUMBER_PLAYERS; i++) {
+        matches->players[i] = playerCreate(i + 1);
+    }
+    ASSERT_TEST_WITH_FREE(matches->tournament && matches->matches,
+                          destroyTableMatches(matches));
+
+    for (int i = 0; i < size; i++) {
+        Player first = matches->players[i % NUMBER_PLAYERS];
+        Player second = matches->players[(i * 3 + 1) % NUMBER_PLAYERS];
+        if (first == second) {
+            second = matches->players[(i + 2) % NUMBER_PLAYERS];
+        }
+        Winner result = (Winner) (i * 7 % 3);
+        Player winner = (FIRST_PLAYER == result) ? first :
+                        (SECOND_PLAYER == result) ? second : NULL;
+        int duration = (i * 7919) % 1000 + (i == size / 2 ? 100000 : 0);
+
+        Match match = matchCreate(first, second, winner,
+                                  matches->tournament, duration);
+        ASSERT_TEST_WITH_FREE(match != NULL, destroyTableMatches(matches));
+        ASSERT_TEST_WITH_FREE(matchVectorPush(matches->matches, match) ==
+                              CHESS_SUCCESS, destroyTableMatches(matches));
+        matches->first_ids[i] = playerGetId(first);
+        matches->second_ids[i] = playerGetId(second);
+        matches->results[i] = result;
+        matches->durations[i] = duration;
+    }
+    return true;
+}
+
+bool testMatchTableCountResults() {
+    for (int size = 0; size <= MAX_SIZE; size++) {
+        TableMatches matches;
+        ASSERT_TEST(createTableMatches(&matches, size));
+        MatchTable table = matchTableCreate(matches.matches);
+        ASSERT_TEST_WITH_FREE(table != NULL, destroyTableMatches(&matches));
+        ASSERT_TEST_WITH_FREE(matchTableGetSize(table) == size,
+            (matchTableDestroy(table), destroyTableMatches(&matches)));
+
+        for (int id = 0; id <= NUMBER_PLAYERS + 1; id++) {
+            MatchTableResults expected = {0, 0, 0};
+            for (int i = 0; i < size; i++) {
+                Winner seat = (matches.first_ids[i] == id) ? FIRST_PLAYER :
+                              (matches.second_ids[i] == id) ? SECOND_PLAYER :
+                              DRAW;
+                if (DRAW == seat) {
+                    continue;
+                }
+                if (DRAW == matches.results[i]) {
+                    expected.draws++;
+                } else if (seat == matches.results[i]) {
+                    expected.wins++;
+                } else {
+                    expected.losses++;
+                }
+            }
+
+            MatchTableResults results;
+            ASSERT_TEST_WITH_FREE(
+                matchTableCountResults(table, id, &results) == CHESS_SUCCESS &&
+                results.wins == expected.wins &&
+                results.draws == expected.draws &&
+                results.losses == expected.losses,
+                (matchTableDestroy(table), destroyTableMatches(&matches)));
+        }
+
+        matchTableDestroy(table);
+        destroyTableMatches(&matches);
+    }
+    return true;
+}
+
+bool testMatchTableDurations() {
+    for (int size = 0; size <= MAX_SIZE; size++) {
+        TableMatches matches;
+        ASSERT_TEST(createTableMatches(&matches, size));
+        MatchTable table = matchTableCreate(matches.matches);
+        ASSERT_TEST_WITH_FREE(table != NULL, destroyTableMatches(&matches));
+
+        long total = 0;
+        int longest = 0;
+        for (int i = 0; i < size; i++) {
+            total += matches.durations[i];
+            longest = (matches.durations[i] > longest) ? matches.durations[i] :
+                                                         longest;
+        }
+        double average = (0 == size) ? 0 : (double) total / size;
+
+        ASSERT_TEST_WITH_FREE(matchTableAverageDuration(table) == average &&
+                              matchTableLongestDuration(table) == longest,
+            (matchTableDestroy(table), destroyTableMatches(&matches)));
+
+        matchTableDestroy(table);
+        destroyTableMatches(&matches);
+    }
+    return true;
+}
+
+bool testMatchTableNullArguments() {
+    MatchTableResults results;
+    ASSERT_TEST(matchTableCreate(NULL) == NULL);
+    ASSERT_TEST(matchTableGetSize(NULL) == 0);
+    ASSERT_TEST(matchTableCountResults(NULL, 1, &results) == CHESS_NULL_ARGUMENT);
+    ASSERT_TEST(matchTableAverageDuration(NULL) == 0);
+    ASSERT_TEST(matchTableLongestDuration(NULL) == 0);
+    matchTableDestroy(NULL);
+    return true;
+}
+
+bool (*tests[]) (void) = {
+        testMatchTableCountResults,
+        testMatchTableDurations,
+        testMatchTableNullArguments
+};
+
+/*The names of the test functions should be added here*/
+const char* testNames[] = {
+        "testMatchTableCountResults",
+        "testMatchTableDurations",
+        "testMatchTableNullArguments"
+};
+
+int main(int argc, char *argv[]) {
+    if (argc == 1) {
+        for (int test_idx = 0; test_idx < NUMBER_TESTS; test_idx++) {
+            RUN_TEST(tests[test_idx], testNames[test_idx]);
+        }
+        return 0;
+    }
+    if (argc != 2) {
+        fprintf(stdout, "Usage: <your_executable_file_name> <test index>\n");
+        return 0;
+    }
+
+    int test_idx = strtol(argv[1], NULL, 10);
+    if (test_idx < 1 || test_idx > NUMBER_TESTS) {
+        fprintf(stderr, "Invalid test index %d\n", test_idx);
+        return 0;
+    }
+
+    RUN_TEST(tests[test_idx - 1], testNames[test_idx - 1]);
+    return 0;
+}
@@ -0,0 +1,171 @@
+#include "test_utilities.h"
+#include <stdlib.h>
+#include "matchvector.h"
+#include "tournament.h"
+#include "player.h"
+
+#define NUMBER_TESTS 2
+#define NUMBER_MATCHES 6
+
+/**
+ * Matches of player 1 against players 2 to NUMBER_MATCHES + 1, held by the
+ * tournament's vector, the system vector of the test and player 1's vector
+ */
+typedef struct hooked_matches_t {
+    Tournament tournament;
+    Player players[NUMBER_MATCHES + 1];
+    MatchVector system;
+    Match matches[NUMBER_MATCHES];
+} HookedMatches;
+
+static void destroyHookedMatches(HookedMatches *hooked) {
+    matchVectorDestroy(hooked->system, false);
+    for (int i = 0; i <= NUMBER_MATCHES; i++) {
+        playerDestroy(hooked->players[i], false);
+    }
+    tournamentDestroy(hooked->tournament);
+}
+
+static bool createHookedMatches(HookedMatches *hooked) {
+    hooked->tournament = tournamentCreate(1, "London", NUMBER_MATCHES);
+    hooked->system = matchVectorCreate(MATCH_HOOK_SYSTEM, NULL);
+    bool created = (hooked->tournament != NULL) && (hooked->system != NULL);
+    for (int i = 0; i <= NUMBER_MATCHES; i++) {
+        hooked->players[i] = playerCreate(i + 1);
+        created = created && (hooked->players[i] != NULL);
+    }
+    ASSERT_TEST_WITH_FREE(created, destroyHookedMatches(hooked));
+
+    for (int i = 0; i < NUMBER_MATCHES; i++) {
+        Match match = matchCreate(hooked->players[0], hooked->players[i + 1],
+                                  NULL, hooked->tournament, i);
+        hooked->matches[i] = match;
+        ASSERT_TEST_WITH_FREE(match != NULL, destroyHookedMatches(hooked));
+        ASSERT_TEST_WITH_FREE(
+            tournamentAddMatch(hooked->tournament, match) == CHESS_SUCCESS &&
+            matchVectorPush(hooked->system, match) == CHESS_SUCCESS &&
+            playerAddMatch(hooked->players[0], match) == CHESS_SUCCESS,
+            destroyHookedMatches(hooked));
+    }
+    return true;
+}
+
+/** Checks every match of the vector knows its position in it */
+static bool positionsMatch(MatchVector vector, MatchHook hook, Player owner) {
+    for (int i = 0; i < matchVectorGetSize(vector); i++) {
+        Match match = matchVectorGet(vector, i);
+        if (*matchGetHook(match, hook, owner) != i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool testMatchVectorRemoveHooked() {
+    HookedMatches hooked;
+    ASSERT_TEST(createHookedMatches(&hooked));
+    Player owner = hooked.players[0];
+    MatchVector tournament = tournamentGetMatches(hooked.tournament);
+    MatchVector player = playerGetMatches(owner);
+
+    // the last match moves into the removed one's place, in this vector only
+    Match removed = hooked.matches[1];
+    ASSERT_TEST_WITH_FREE(matchVectorRemove(hooked.system, removed),
+                          destroyHookedMatches(&hooked));
+    ASSERT_TEST_WITH_FREE(*matchGetHook(removed, MATCH_HOOK_SYSTEM, NULL) == -1,
+                          destroyHookedMatches(&hooked));
+    ASSERT_TEST_WITH_FREE(matchVectorGetSize(hooked.system) == NUMBER_MATCHES - 1 &&
+                          matchVectorGet(hooked.system, 1) ==
+                          hooked.matches[NUMBER_MATCHES - 1],
+                          destroyHookedMatches(&hooked));
+    ASSERT_TEST_WITH_FREE(positionsMatch(hooked.system, MATCH_HOOK_SYSTEM, NULL) &&
+                          positionsMatch(tournament, MATCH_HOOK_TOURNAMENT, NULL) &&
+                          positionsMatch(player, MATCH_HOOK_PLAYER, owner),
+                          destroyHookedMatches(&hooked));
+    ASSERT_TEST_WITH_FREE(*matchGetHook(removed, MATCH_HOOK_TOURNAMENT, NULL) == 1 &&
+                          *matchGetHook(removed, MATCH_HOOK_PLAYER, owner) == 1,
+                          destroyHookedMatches(&hooked));
+
+    // a match which is no longer in the vector is not removed again
+    ASSERT_TEST_WITH_FREE(!matchVectorRemove(hooked.system, removed),
+                          destroyHookedMatches(&hooked));
+    ASSERT_TEST_WITH_FREE(matchVectorGetSize(hooked.system) == NUMBER_MATCHES - 1,
+                          destroyHookedMatches(&hooked));
+
+    // removing the last match and the first one, from the player's vector
+    ASSERT_TEST_WITH_FREE(
+        matchVectorRemove(player, hooked.matches[NUMBER_MATCHES - 1]) &&
+        matchVectorRemove(player, hooked.matches[0]),
+        destroyHookedMatches(&hooked));
+    ASSERT_TEST_WITH_FREE(matchVectorGetSize(player) == NUMBER_MATCHES - 2 &&
+                          positionsMatch(player, MATCH_HOOK_PLAYER, owner),
+                          destroyHookedMatches(&hooked));
+    ASSERT_TEST_WITH_FREE(
+        *matchGetHook(hooked.matches[0], MATCH_HOOK_PLAYER, owner) == -1 &&
+        *matchGetHook(hooked.matches[0], MATCH_HOOK_PLAYER, hooked.players[1]) == -1,
+        destroyHookedMatches(&hooked));
+
+    // the vector being destroyed leaves its matches out of it
+    matchVectorDestroy(hooked.system, false);
+    hooked.system = NULL;
+    ASSERT_TEST_WITH_FREE(
+        *matchGetHook(hooked.matches[2], MATCH_HOOK_SYSTEM, NULL) == -1,
+        destroyHookedMatches(&hooked));
+
+    destroyHookedMatches(&hooked);
+    return true;
+}
+
+bool testMatchVectorRemoveUnhooked() {
+    HookedMatches hooked;
+    ASSERT_TEST(createHookedMatches(&hooked));
+    MatchVector copy = matchVectorCopy(hooked.system);
+    ASSERT_TEST_WITH_FREE(copy != NULL, destroyHookedMatches(&hooked));
+
+    // the copy is scanned, and doesn't touch the positions of the original
+    ASSERT_TEST_WITH_FREE(matchVectorRemove(copy, hooked.matches[0]) &&
+                          !matchVectorRemove(copy, hooked.matches[0]),
+                          (matchVectorDestroy(copy, false),
+                           destroyHookedMatches(&hooked)));
+    ASSERT_TEST_WITH_FREE(matchVectorGetSize(copy) == NUMBER_MATCHES - 1 &&
+                          positionsMatch(hooked.system, MATCH_HOOK_SYSTEM, NULL),
+                          (matchVectorDestroy(copy, false),
+                           destroyHookedMatches(&hooked)));
+
+    matchVectorDestroy(copy, false);
+    destroyHookedMatches(&hooked);
+    return true;
+}
+
+bool (*tests[]) (void) = {
+        testMatchVectorRemoveHooked,
+        testMatchVectorRemoveUnhooked
+};
+
+/*The names of the test functions should be added here*/
+const char* testNames[] = {
+        "testMatchVectorRemoveHooked",
+        "testMatchVectorRemoveUnhooked"
+};
+
+int main(int argc, char *argv[]) {
+    if (argc == 1) {
+        for (int test_idx = 0; test_idx < NUMBER_TESTS; test_idx++) {
+            RUN_TEST(tests[test_idx], testNames[test_idx]);
+        }
+        return 0;
+    }
+    if (argc != 2) {
+        fprintf(stdout, "Usage: <your_executable_file_name> <test index>\n");
+        return 0;
+    }
+
+    int test_idx = strtol(argv[1], NULL, 10);
+    if (test_idx < 1 || test_idx > NUMBER_TESTS) {
+        fprintf(stderr, "Invalid test index %d\n", test_idx);
+        return 0;
+    }
+
+    RUN_TEST(tests[test_idx - 1], testNames[test_idx - 1]);
+    return 0;
+}
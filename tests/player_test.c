@@ -0,0 +1,166 @@
+#include "test_utilities.h"
+#include <stdlib.h>
+#include "player.h"
+#include "tournament.h"
+
+#define NUMBER_TESTS 2
+#define NUMBER_PLAYERS 3
+
+/**
+ * Players 1 to 3 of a tournament, with three games held by both of their
+ * participants: 1 beats 2 in 10 seconds, 1 draws with 3 in 20 seconds and
+ * 3 beats 2 in 30 seconds.
+ */
+typedef struct player_games_t {
+    Tournament tournament;
+    Player players[NUMBER_PLAYERS];
+    Match games[3];
+} PlayerGames;
+
+static void destroyPlayerGames(PlayerGames *games) {
+    for (int i = 0; i < NUMBER_PLAYERS; i++) {
+        playerDestroy(games->players[i], false);
+    }
+    tournamentDestroy(games->tournament);
+}
+
+static bool createPlayerGames(PlayerGames *games) {
+    games->tournament = tournamentCreate(1, "London", 2);
+    bool created = (games->tournament != NULL);
+    for (int i = 0; i < NUMBER_PLAYERS; i++) {
+        games->players[i] = playerCreate(i + 1);
+        created = created && (games->players[i] != NULL);
+    }
+    ASSERT_TEST_WITH_FREE(created, destroyPlayerGames(games));
+
+    Player *players = games->players;
+    games->games[0] = matchCreate(players[0], players[1], players[0],
+                                  games->tournament, 10);
+    games->games[1] = matchCreate(players[0], players[2], NULL,
+                                  games->tournament, 20);
+    games->games[2] = matchCreate(players[1], players[2], players[2],
+                                  games->tournament, 30);
+    for (int i = 0; i < 3; i++) {
+        Match game = games->games[i];
+        ASSERT_TEST_WITH_FREE(game != NULL, destroyPlayerGames(games));
+        ASSERT_TEST_WITH_FREE(
+            playerAddMatch(matchGetFirst(game), game) == CHESS_SUCCESS &&
+            playerAddMatch(matchGetSecond(game), game) == CHESS_SUCCESS,
+            destroyPlayerGames(games));
+    }
+    return true;
+}
+
+bool testPlayerTotalsAfterForfeit() {
+    PlayerGames games;
+    ASSERT_TEST(createPlayerGames(&games));
+    Player *players = games.players;
+
+    // score = (6 * wins + 2 * draws - 10 * losses) / games
+    ASSERT_TEST_WITH_FREE(playerGetScore(players[0]) == 4 &&
+                          playerGetScore(players[1]) == -10 &&
+                          playerGetScore(players[2]) == 4,
+                          destroyPlayerGames(&games));
+    ASSERT_TEST_WITH_FREE(playerGetAveragePlayTime(players[0]) == 15 &&
+                          playerGetAveragePlayTime(players[1]) == 20 &&
+                          playerGetAveragePlayTime(players[2]) == 25,
+                          destroyPlayerGames(&games));
+
+    // 1 forfeits his draw with 3
+    ASSERT_TEST_WITH_FREE(matchSetLoser(games.games[1], players[0]) ==
+                          CHESS_SUCCESS, destroyPlayerGames(&games));
+    ASSERT_TEST_WITH_FREE(playerGetScore(players[0]) == -2 &&
+                          playerGetScore(players[2]) == 6,
+                          destroyPlayerGames(&games));
+
+    // the win of 1 over 2 turns into a draw, a non participant can't win it
+    ASSERT_TEST_WITH_FREE(matchSetWinner(games.games[0], NULL) == CHESS_SUCCESS,
+                          destroyPlayerGames(&games));
+    ASSERT_TEST_WITH_FREE(matchSetWinner(games.games[0], players[2]) ==
+                          CHESS_PLAYER_NOT_EXIST, destroyPlayerGames(&games));
+    ASSERT_TEST_WITH_FREE(matchSetLoser(games.games[0], players[2]) ==
+                          CHESS_PLAYER_NOT_EXIST, destroyPlayerGames(&games));
+    ASSERT_TEST_WITH_FREE(playerGetScore(players[0]) == -4 &&
+                          playerGetScore(players[1]) == -4 &&
+                          playerGetScore(players[2]) == 6,
+                          destroyPlayerGames(&games));
+
+    // a forfeit doesn't change how long the games took
+    ASSERT_TEST_WITH_FREE(playerGetAveragePlayTime(players[0]) == 15 &&
+                          playerGetAveragePlayTime(players[1]) == 20 &&
+                          playerGetAveragePlayTime(players[2]) == 25,
+                          destroyPlayerGames(&games));
+
+    // a removed game is taken out of the totals of its player only
+    ASSERT_TEST_WITH_FREE(playerRemoveMatch(players[0], games.games[0]) ==
+                          CHESS_SUCCESS, destroyPlayerGames(&games));
+    ASSERT_TEST_WITH_FREE(playerGetScore(players[0]) == -10 &&
+                          playerGetAveragePlayTime(players[0]) == 20 &&
+                          playerGetScore(players[1]) == -4,
+                          destroyPlayerGames(&games));
+
+    destroyPlayerGames(&games);
+    return true;
+}
+
+bool testPlayerTotalsAfterOpponentRemoved() {
+    PlayerGames games;
+    ASSERT_TEST(createPlayerGames(&games));
+    Player *players = games.players;
+
+    // 1 leaves his games: 2 keeps his loss to him, 3 keeps the draw
+    playerDestroy(players[0], true);
+    players[0] = NULL;
+    Player winner;
+    ASSERT_TEST_WITH_FREE(matchGetFirst(games.games[0]) == NULL &&
+                          matchGetResult(games.games[0]) == FIRST_PLAYER &&
+                          matchGetWinner(games.games[0], &winner) == CHESS_SUCCESS &&
+                          winner == NULL,
+                          destroyPlayerGames(&games));
+    ASSERT_TEST_WITH_FREE(playerGetScore(players[1]) == -10 &&
+                          playerGetScore(players[2]) == 4,
+                          destroyPlayerGames(&games));
+
+    // a later forfeit is counted for the remaining participant only
+    ASSERT_TEST_WITH_FREE(matchSetWinner(games.games[0], players[1]) ==
+                          CHESS_SUCCESS, destroyPlayerGames(&games));
+    ASSERT_TEST_WITH_FREE(playerGetScore(players[1]) == -2 &&
+                          playerGetAveragePlayTime(players[1]) == 20,
+                          destroyPlayerGames(&games));
+
+    destroyPlayerGames(&games);
+    return true;
+}
+
+bool (*tests[]) (void) = {
+        testPlayerTotalsAfterForfeit,
+        testPlayerTotalsAfterOpponentRemoved
+};
+
+/*The names of the test functions should be added here*/
+const char* testNames[] = {
+        "testPlayerTotalsAfterForfeit",
+        "testPlayerTotalsAfterOpponentRemoved"
+};
+
+int main(int argc, char *argv[]) {
+    if (argc == 1) {
+        for (int test_idx = 0; test_idx < NUMBER_TESTS; test_idx++) {
+            RUN_TEST(tests[test_idx], testNames[test_idx]);
+        }
+        return 0;
+    }
+    if (argc != 2) {
+        fprintf(stdout, "Usage: <your_executable_file_name> <test index>\n");
+        return 0;
+    }
+
+    int test_idx = strtol(argv[1], NULL, 10);
+    if (test_idx < 1 || test_idx > NUMBER_TESTS) {
+        fprintf(stderr, "Invalid test index %d\n", test_idx);
+        return 0;
+    }
+
+    RUN_TEST(tests[test_idx - 1], testNames[test_idx - 1]);
+    return 0;
+}
@@ -0,0 +1,145 @@
+#include "test_utilities.h"
+#include <stdlib.h>
+#include <pthread.h>
+#include "read_mostly_map.h"
+
+#define NUMBER_TESTS 2
+#define NUMBER_READERS 3
+#define NUMBER_WRITES 2000
+
+/** Function to be used for copying an int as a key or data to the map */
+static MapKeyElement copyInt(MapKeyElement n) {
+    if (!n) {
+        return NULL;
+    }
+    int *copy = malloc(sizeof(*copy));
+    if (!copy) {
+        return NULL;
+    }
+    *copy = *(int *) n;
+    return copy;
+}
+
+/** Function to be used by the map for freeing elements */
+static void freeInt(MapKeyElement n) {
+    free(n);
+}
+
+/** Function to be used by the map for comparing elements */
+static int compareInts(MapKeyElement n1, MapKeyElement n2) {
+    return (*(int *) n1 - *(int *) n2);
+}
+
+/** Set by the writer once it is done */
+static int writer_done = 0;
+
+/**
+ * Thread reading versions of the map until the writer is done. The writer
+ * only puts the keys 0, 1, 2... in order, each paired with twice its value,
+ * so every version must hold exactly the keys below its size.
+ */
+static void *readVersions(void *argument) {
+    ReadMostlyMapReader reader = readMostlyMapRegisterReader(argument);
+    bool consistent = reader != NULL;
+    while (consistent && !__atomic_load_n(&writer_done, __ATOMIC_ACQUIRE)) {
+        Map version = readMostlyMapReadBegin(reader);
+        int expected = 0;
+        MAP_ITERATE(iterator, version) {
+            if (*(int *) mapIteratorKey(&iterator) != expected ||
+                *(int *) mapIteratorData(&iterator) != 2 * expected) {
+                consistent = false;
+            }
+            expected++;
+        }
+        if (expected != mapGetSize(version)) {
+            consistent = false;
+        }
+        readMostlyMapReadEnd(reader);
+    }
+    readMostlyMapUnregisterReader(reader);
+    return consistent ? argument : NULL;
+}
+
+bool testReadMostlyMapVersions() {
+    ReadMostlyMap map = readMostlyMapCreate(copyInt, copyInt, freeInt, freeInt,
+                                            compareInts);
+    ReadMostlyMapReader reader = readMostlyMapRegisterReader(map);
+    ASSERT_TEST(reader != NULL);
+
+    int key = 1, data = 10;
+    ASSERT_TEST(readMostlyMapPut(map, &key, &data) == MAP_SUCCESS);
+    Map old = readMostlyMapReadBegin(reader);
+
+    // a version stays intact while its reader uses it
+    data = 20;
+    ASSERT_TEST(readMostlyMapPut(map, &key, &data) == MAP_SUCCESS);
+    ASSERT_TEST(readMostlyMapRemove(map, &key) == MAP_SUCCESS);
+    ASSERT_TEST(readMostlyMapRemove(map, &key) == MAP_ITEM_DOES_NOT_EXIST);
+    ASSERT_TEST(*(int *) mapGet(old, &key) == 10);
+    readMostlyMapReadEnd(reader);
+
+    Map current = readMostlyMapReadBegin(reader);
+    ASSERT_TEST(mapGetSize(current) == 0);
+    ASSERT_TEST(!mapContains(current, &key));
+    readMostlyMapReadEnd(reader);
+
+    readMostlyMapUnregisterReader(reader);
+    readMostlyMapDestroy(map);
+    return true;
+}
+
+bool testReadMostlyMapThreads() {
+    ReadMostlyMap map = readMostlyMapCreate(copyInt, copyInt, freeInt, freeInt,
+                                            compareInts);
+    pthread_t readers[NUMBER_READERS];
+
+    for (int i = 0; i < NUMBER_READERS; ++i) {
+        ASSERT_TEST(pthread_create(&readers[i], NULL, readVersions, map) == 0);
+    }
+    for (int i = 0; i < NUMBER_WRITES; ++i) {
+        int data = 2 * i;
+        ASSERT_TEST(readMostlyMapPut(map, &i, &data) == MAP_SUCCESS);
+    }
+    __atomic_store_n(&writer_done, 1, __ATOMIC_RELEASE);
+    for (int i = 0; i < NUMBER_READERS; ++i) {
+        void *result;
+        ASSERT_TEST(pthread_join(readers[i], &result) == 0);
+        ASSERT_TEST(result == map);
+    }
+
+    readMostlyMapDestroy(map);
+    return true;
+}
+
+bool (*tests[]) (void) = {
+        testReadMostlyMapVersions,
+        testReadMostlyMapThreads
+};
+
+/*The names of the test functions should be added here*/
+const char* testNames[] = {
+        "testReadMostlyMapVersions",
+        "testReadMostlyMapThreads"
+};
+
+int main(int argc, char *argv[]) {
+    if (argc == 1) {
+        for (int test_idx = 0; test_idx < NUMBER_TESTS; test_idx++) {
+            RUN_TEST(tests[test_idx], testNames[test_idx]);
+        }
+        return 0;
+    }
+    if (argc != 2) {
+        fprintf(stdout, "Usage: <your_executable_file_name> <test index>\n");
+        return 0;
+    }
+
+    int test_idx = strtol(argv[1], NULL, 10);
+    if (test_idx < 1 || test_idx > NUMBER_TESTS) {
+        fprintf(stderr, "Invalid test index %d\n", test_idx);
+        return 0;
+    }
+
+    RUN_TEST(tests[test_idx - 1], testNames[test_idx - 1]);
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include "test_utilities.h"
+#include <stdlib.h>
+#include "tournament.h"
+#include "player.h"
+
+#define NUMBER_TESTS 3
+#define NUMBER_PLAYERS 4
+
+/** A tournament and its players, ids 1 to NUMBER_PLAYERS */
+typedef struct tournament_players_t {
+    Tournament tournament;
+    Player players[NUMBER_PLAYERS];
+} TournamentPlayers;
+
+static void destroyTournamentPlayers(TournamentPlayers *tournament) {
+    tournamentDestroy(tournament->tournament);
+    for (int i = 0; i < NUMBER_PLAYERS; i++) {
+        playerDestroy(tournament->players[i], false);
+    }
+}
+
+static bool createTournamentPlayers(TournamentPlayers *tournament) {
+    tournament->tournament = tournamentCreate(1, "London", 4);
+    bool created = (tournament->tournament != NULL);
+    for (int i = 0; i < NUMBER_PLAYERS; i++) {
+        tournament->players[i] = playerCreate(i + 1);
+        created = created && (tournament->players[i] != NULL);
+    }
+    ASSERT_TEST_WITH_FREE(created, destroyTournamentPlayers(tournament));
+    return true;
+}
+
+/** Adds a game between the players of the ids, winner 0 for a draw */
+static Match addGame(TournamentPlayers *tournament, int first, int second,
+                     int winner) {
+    Player first_player = tournament->players[first - 1];
+    Player second_player = tournament->players[second - 1];
+    Player winner_player = (winner == first) ? first_player :
+                           (winner == second) ? second_player : NULL;
+    Match match = matchCreate(first_player, second_player, winner_player,
+                              tournament->tournament, 60);
+    if (match == NULL) {
+        return NULL;
+    }
+    if (tournamentAddMatch(tournament->tournament, match) != CHESS_SUCCESS) {
+        matchDestroy(match);
+        return NULL;
+    }
+    return match;
+}
+
+/**
+ * Adds the games of the tests: player 1 beats 2, 3 draws with 4, 3 beats 2
+ * and 4 beats 1. Players 3 and 4 lead with 3 points each.
+ */
+static bool addGames(TournamentPlayers *tournament, Match *last) {
+    ASSERT_TEST(addGame(tournament, 1, 2, 1) != NULL);
+    ASSERT_TEST(addGame(tournament, 3, 4, 0) != NULL);
+    ASSERT_TEST(addGame(tournament, 2, 3, 3) != NULL);
+    *last = addGame(tournament, 4, 1, 4);
+    ASSERT_TEST(*last != NULL);
+    return true;
+}
+
+bool testTournamentEndWinner() {
+    TournamentPlayers tournament;
+    Match last;
+    ASSERT_TEST(createTournamentPlayers(&tournament));
+    ASSERT_TEST_WITH_FREE(addGames(&tournament, &last),
+                          destroyTournamentPlayers(&tournament));
+    ASSERT_TEST_WITH_FREE(tournamentGetWinnerId(tournament.tournament) == 0,
+                          destroyTournamentPlayers(&tournament));
+
+    // the tie between 3 and 4 goes to the lower id
+    ASSERT_TEST_WITH_FREE(tournamentEnd(tournament.tournament) == CHESS_SUCCESS,
+                          destroyTournamentPlayers(&tournament));
+    ASSERT_TEST_WITH_FREE(tournamentIsEnded(tournament.tournament),
+                          destroyTournamentPlayers(&tournament));
+    ASSERT_TEST_WITH_FREE(tournamentGetWinnerId(tournament.tournament) == 3,
+                          destroyTournamentPlayers(&tournament));
+
+    // an ended tournament keeps its results and its winner
+    ASSERT_TEST_WITH_FREE(tournamentRemovePlayer(tournament.tournament, 3) ==
+                          CHESS_SUCCESS, destroyTournamentPlayers(&tournament));
+    ASSERT_TEST_WITH_FREE(tournamentGetWinnerId(tournament.tournament) == 3,
+                          destroyTournamentPlayers(&tournament));
+
+    destroyTournamentPlayers(&tournament);
+    return true;
+}
+
+bool testTournamentEndAfterForfeit() {
+    TournamentPlayers tournament;
+    Match last;
+    ASSERT_TEST(createTournamentPlayers(&tournament));
+    ASSERT_TEST_WITH_FREE(addGames(&tournament, &last),
+                          destroyTournamentPlayers(&tournament));
+
+    // 3 forfeits his draw with 4 and his win over 2: 1 and 2 have 2 points,
+    // 4 has 4
+    ASSERT_TEST_WITH_FREE(tournamentRemovePlayer(tournament.tournament, 3) ==
+                          CHESS_SUCCESS, destroyTournamentPlayers(&tournament));
+    ASSERT_TEST_WITH_FREE(tournamentEnd(tournament.tournament) == CHESS_SUCCESS,
+                          destroyTournamentPlayers(&tournament));
+    ASSERT_TEST_WITH_FREE(tournamentGetWinnerId(tournament.tournament) == 4,
+                          destroyTournamentPlayers(&tournament));
+
+    destroyTournamentPlayers(&tournament);
+    return true;
+}
+
+bool testTournamentEndAfterRemoveMatch() {
+    TournamentPlayers tournament;
+    Match last;
+    ASSERT_TEST(createTournamentPlayers(&tournament));
+    ASSERT_TEST_WITH_FREE(addGames(&tournament, &last),
+                          destroyTournamentPlayers(&tournament));
+
+    // without the win of 4 over 1, and with the forfeits of 3, players 1, 2
+    // and 4 tie with 2 points
+    ASSERT_TEST_WITH_FREE(tournamentRemoveMatch(tournament.tournament, last) ==
+                          CHESS_SUCCESS, destroyTournamentPlayers(&tournament));
+    matchDestroy(last);
+    ASSERT_TEST_WITH_FREE(tournamentRemovePlayer(tournament.tournament, 3) ==
+                          CHESS_SUCCESS, destroyTournamentPlayers(&tournament));
+    ASSERT_TEST_WITH_FREE(tournamentEnd(tournament.tournament) == CHESS_SUCCESS,
+                          destroyTournamentPlayers(&tournament));
+    ASSERT_TEST_WITH_FREE(tournamentGetWinnerId(tournament.tournament) == 1,
+                          destroyTournamentPlayers(&tournament));
+
+    destroyTournamentPlayers(&tournament);
+    return true;
+}
+
+bool (*tests[]) (void) = {
+        testTournamentEndWinner,
+        testTournamentEndAfterForfeit,
+        testTournamentEndAfterRemoveMatch
+};
+
+/*The names of the test functions should be added here*/
+const char* testNames[] = {
+        "testTournamentEndWinner",
+        "testTournamentEndAfterForfeit",
+        "testTournamentEndAfterRemoveMatch"
+};
+
+int main(int argc, char *argv[]) {
+    if (argc == 1) {
+        for (int test_idx = 0; test_idx < NUMBER_TESTS; test_idx++) {
+            RUN_TEST(tests[test_idx], testNames[test_idx]);
+        }
+        return 0;
+    }
+    if (argc != 2) {
+        fprintf(stdout, "Usage: <your_executable_file_name> <test index>\n");
+        return 0;
+    }
+
+    int test_idx = strtol(argv[1], NULL, 10);
+    if (test_idx < 1 || test_idx > NUMBER_TESTS) {
+        fprintf(stderr, "Invalid test index %d\n", test_idx);
+        return 0;
+    }
+
+    RUN_TEST(tests[test_idx - 1], testNames[test_idx - 1]);
+    return 0;
+}
@@ -1,24 +1,153 @@
 #include "tournament.h"
-#include "matchnode.h"
+#include "matchvector.h"
 #include "player.h"
 #include "map.h"
 #include "string.h"
 
 struct tournament_t {
   int id;
-  matchNode matches;
+  MatchVector matches;
+  MatchArena arena; //memory of the matches, released in one shot
   Map players;
   char *location;
   int max_matches_per_player;
   int players_count;
   bool finished;
-  Player winner;
+  int winner_id; //an id, as the winner may be removed from the system later
 };
-static MapKeyElement copyId(MapKeyElement element);
-static void freeId(MapKeyElement element);
+
+/**
+ * A participant of the tournament, the data of the tournament's players map.
+ * Keeping the number of games played lets the max games per player limit be
+ * checked with a single lookup, and keeping the ids of the opponents lets a
+ * repeated game between the same pair be found with a single lookup as well.
+ * The results are counted as the games are added, so ending the tournament
+ * visits every player once and no game at all.
+ */
+typedef struct tournament_player_t {
+  Player player; //owned by the chess system, NULL once removed from an ended tournament
+  int games; //games played in the tournament
+  int wins; //games won in the tournament
+  int draws; //games ended in a draw in the tournament
+  Map opponents; //opponent id -> their game, the games belong to the tournament
+} *TournamentPlayer;
+
+//the games in the opponents maps are borrowed, so they are neither copied nor freed
+static MapDataElement opponentMatchCopy(MapDataElement match)
+{
+  return match;
+}
+
+static void opponentMatchFree(MapDataElement match)
+{
+  (void)match;
+}
+
+static MapDataElement tournamentPlayerCreate(MapKeyElement key, void *player)
+{
+  (void)key;
+  TournamentPlayer participant = (TournamentPlayer) malloc(sizeof(*participant));
+  if(participant == NULL)
+  {
+    return NULL;
+  }
+  participant->opponents = mapCreateIntKeyed(opponentMatchCopy, opponentMatchFree);
+  if(participant->opponents == NULL)
+  {
+    free(participant);
+    return NULL;
+  }
+  participant->player = (Player) player;
+  participant->games = 0;
+  participant->wins = 0;
+  participant->draws = 0;
+  return participant;
+}
+
+static void tournamentPlayerDestroy(MapDataElement participant)
+{
+  if(participant == NULL)
+  {
+    return;
+  }
+  mapDestroy(((TournamentPlayer) participant)->opponents);
+  free(participant);
+}
+
+static MapDataElement tournamentPlayerCopy(MapDataElement original)
+{
+  TournamentPlayer copy = tournamentPlayerCreate(NULL, ((TournamentPlayer) original)->player);
+  if(copy == NULL)
+  {
+    return NULL;
+  }
+  copy->games = ((TournamentPlayer) original)->games;
+  copy->wins = ((TournamentPlayer) original)->wins;
+  copy->draws = ((TournamentPlayer) original)->draws;
+  mapDestroy(copy->opponents);
+  copy->opponents = mapCopy(((TournamentPlayer) original)->opponents);
+  if(copy->opponents == NULL)
+  {
+    free(copy);
+    return NULL;
+  }
+  return copy;
+}
+
+/**
+ * Counts a game less for a participant, who leaves the tournament once he has
+ * no games left in it
+ */
+static void tournamentPlayerRemoveGame(Tournament tournament, Player player, Player opponent)
+{
+  int player_id = playerGetId(player);
+  int opponent_id = playerGetId(opponent);
+  TournamentPlayer participant = mapGet(tournament->players, (MapKeyElement) &player_id);
+  if(participant == NULL)
+  {
+    return;
+  }
+  mapRemove(participant->opponents, (MapKeyElement) &opponent_id);
+  participant->games--;
+  if(participant->games == 0)
+  {
+    mapRemove(tournament->players, (MapKeyElement) &player_id);
+    tournament->players_count--;
+  }
+}
+
+/**
+ * Counts the result of a game for its participants in the tournament, or
+ * takes it out of their results
+ */
+static void tournamentCountResult(Tournament tournament, Match match, bool count)
+{
+  int change = count ? 1 : -1;
+  Winner result = matchGetResult(match);
+  Player players[] = {matchGetFirst(match), matchGetSecond(match)};
+  Winner seats[] = {FIRST_PLAYER, SECOND_PLAYER};
+  for(int i = 0; i < 2; i++)
+  {
+    int player_id = playerGetId(players[i]);
+    TournamentPlayer participant = mapGet(tournament->players, (MapKeyElement) &player_id);
+    if(participant == NULL) //a removed player has no results to keep
+    {
+      continue;
+    }
+    if(result == seats[i])
+    {
+      participant->wins += change;
+    }
+    else if(result == DRAW)
+    {
+      participant->draws += change;
+    }
+  }
+}
+
 static bool isLocationValid(const char *location)
 {
-  char* ptr = location;
+  const char* ptr = location;
   if(*ptr < 'A' || *ptr > 'Z') //checking location begins with capital letter
   {
     return false;
@@ -49,28 +178,41 @@ Tournament tournamentCreate(int id, const char *location, int max_games_per_play
     return NULL;
   }
   tournament->id = id;
-  tournament->matches = NULL;
-  tournament->players =  mapCreate(playerCopy, 
-                             copyId, 
-                             playerDestroy, 
-                             freeId, 
-                             playerCompare);
+  tournament->matches = matchVectorCreate(MATCH_HOOK_TOURNAMENT, NULL);
+  if(tournament->matches == NULL)
+  {
+    free(tournament);
+    return NULL;
+  }
+  tournament->arena = matchArenaCreate();
+  if(tournament->arena == NULL)
+  {
+    matchVectorDestroy(tournament->matches, false);
+    free(tournament);
+    return NULL;
+  }
+  tournament->players = mapCreateIntKeyed(tournamentPlayerCopy, tournamentPlayerDestroy);
   if(tournament->players == NULL)
   {
+    matchArenaDestroy(tournament->arena);
+    matchVectorDestroy(tournament->matches, false);
+    free(tournament);
     return NULL;
   }
   tournament->players_count = 0;
-  int length = strlen(*location);
-  char* new_loc = (char*) malloc(sizeof(char) * length);
+  int length = strlen(location);
+  char* new_loc = (char*) malloc(sizeof(char) * (length + 1));
   tournament->location = new_loc;
   tournament->max_matches_per_player = max_games_per_player;
   tournament->finished = false;
-  tournament->winner = NULL;
+  tournament->winner_id = 0;
   if(new_loc == NULL)
   {
     tournamentDestroy(tournament);
     return NULL;
   }
+  strcpy(new_loc, location);
+  return tournament;
 }
 
 ChessResult tournamentAddMatch(Tournament tournament, Match match)
@@ -83,75 +225,122 @@ ChessResult tournamentAddMatch(Tournament tournament, Match match)
   {
     return CHESS_TOURNAMENT_ENDED;
   }
-  if(mapContains(tournament->matches, match)) // match already in the tournament
+  Player first_player = matchGetFirst(match);
+  Player second_player = matchGetSecond(match);
+  int first_id = playerGetId(first_player);
+  int second_id = playerGetId(second_player);
+  //a single lookup per player gives the games he already played here
+  TournamentPlayer first = mapGet(tournament->players, (MapKeyElement) &first_id);
+  TournamentPlayer second = mapGet(tournament->players, (MapKeyElement) &second_id);
+  //the pair already played if the first player has the second as an opponent
+  if(first != NULL && second != NULL && mapContains(first->opponents, (MapKeyElement) &second_id))
   {
     return CHESS_GAME_ALREADY_EXISTS;
   }
-  //creating list of matches played in the tournament by the players in @param match
-  matchNode player1_matches;
-  matchNode player2_matches;
-  ChessResult first = tournamentGetMatchesByPlayer(tournament, matchGetFIrst(match), player1_matches);
-  ChessResult second = tournamentGetMatchesByPlayer(tournament, matchGetFIrst(match), player1_matches);
-  if(getSize(player1_matches) > tournament->max_matches_per_player || getSize(player2_matches) > tournament->max_matches_per_player)
-  //if the number of matches played by one (or both) of them is too much, abbort
+  if((first != NULL && first->games >= tournament->max_matches_per_player) ||
+     (second != NULL && second->games >= tournament->max_matches_per_player))
+  //if one (or both) of them already played the maximal number of matches, abbort
   {
-    matchNodeDestroy(player1_matches, false);
-    matchNodeDestroy(player2_matches, false);
-    return CHESS_INVALID_MAX_GAMES;
+    return CHESS_EXCEEDED_GAMES;
   }
   //now adding the match to list of matches
-  if(newMatchNode(match, tournament->matches) == NULL)
+  if(matchVectorPush(tournament->matches, match) != CHESS_SUCCESS)
   {
-    matchNodeDestroy(player1_matches, false);
-    matchNodeDestroy(player2_matches, false);
     return CHESS_OUT_OF_MEMORY;
   }
-  //now dealing with the players
-  Player first_player = matchGetFirst(match);
-  Player second_player = matchGetSecond(match);
-  if(first == CHESS_PLAYER_NOT_EXIST) //this is the first game in the tournament played by first_player
+  int last = matchVectorGetSize(tournament->matches) - 1;
+  //now dealing with the players, who are added on their first game in the tournament
+  bool first_added = (first == NULL);
+  if(first_added)
   {
-    //adding the player to players map
-    first = mapPut(tournament->players, playerGetId(first_player), first_player);
-    if(first == CHESS_OUT_OF_MEMORY)
+    first = mapGetOrInsert(tournament->players, (MapKeyElement) &first_id, tournamentPlayerCreate, first_player);
+    if(first == NULL)
     {
-      matchNodeDestroy(player1_matches, false);
-      matchNodeDestroy(player2_matches, false);
-      tournamentRemoveMatch(tournament, match);
+      matchVectorRemoveAt(tournament->matches, last);
       return CHESS_OUT_OF_MEMORY;
     }
     tournament->players_count ++;
-    first = CHESS_PLAYER_NOT_EXIST; //flag to signify we added the first_player just now for the 1st time
   }
   //same with second_player
-  if(second == CHESS_PLAYER_NOT_EXIST)
+  if(second == NULL)
   {
-    //adding 2nd player to players map
-    second = mapPut(tournament->players, playerGetId(second_player), second_player);
-    if(second == CHESS_OUT_OF_MEMORY)
+    second = mapGetOrInsert(tournament->players, (MapKeyElement) &second_id, tournamentPlayerCreate, second_player);
+    if(second == NULL)
     {
-      matchNodeDestroy(player1_matches, false);
-      matchNodeDestroy(player2_matches, false);
-      tournamentRemoveMatch(tournament, match);
-      if(first == CHESS_PLAYER_NOT_EXIST) //first_player was added now for the 1st time so he as well needs to be removed
+      matchVectorRemoveAt(tournament->matches, last);
+      if(first_added) //first_player was added now for the 1st time so he as well needs to be removed
       {
-        tournamentRemovePlayer(tournament, playerGetId(first_player));
+        mapRemove(tournament->players, (MapKeyElement) &first_id);
+        tournament->players_count --;
       }
       return CHESS_OUT_OF_MEMORY;
     }
-   tournament->players_count ++;
-  }  
-  matchNodeDestroy(player1_matches, false);
-  matchNodeDestroy(player2_matches, false);
+    tournament->players_count ++;
+  }
+  first->games++;
+  second->games++;
+  tournamentCountResult(tournament, match, true);
+  //the pair is kept on both sides, so it can be dropped from either of them
+  if(mapPut(first->opponents, (MapKeyElement) &second_id, match) != MAP_SUCCESS ||
+     mapPut(second->opponents, (MapKeyElement) &first_id, match) != MAP_SUCCESS)
+  {
+    tournamentRemoveMatch(tournament, match);
+    return CHESS_OUT_OF_MEMORY;
+  }
   return CHESS_SUCCESS;
 }
 
 ChessResult tournamentRemovePlayer(Tournament tournament, int player_id)
 {
-
+  if(tournament == NULL)
+  {
+    return CHESS_NULL_ARGUMENT;
+  }
+  TournamentPlayer participant = mapGet(tournament->players, (MapKeyElement) &player_id);
+  if(participant == NULL)
+  {
+    return CHESS_SUCCESS;
+  }
+  //results of ended tournaments are kept as they are, without the player
+  if(tournament->finished)
+  {
+    participant->player = NULL;
+    return CHESS_SUCCESS;
+  }
+  //the opponents map holds the player's games, so the matches aren't scanned.
+  //the opponents keep their games, but may play a new player with the same id
+  MAP_ITERATE(iterator, participant->opponents)
+  {
+    Match match = mapIteratorData(&iterator);
+    tournamentCountResult(tournament, match, false);
+    matchSetLoser(match, participant->player); //the opponent wins by forfeit
+    tournamentCountResult(tournament, match, true);
+    TournamentPlayer opponent = mapGet(tournament->players, mapIteratorKey(&iterator));
+    if(opponent != NULL)
+    {
+      mapRemove(opponent->opponents, (MapKeyElement) &player_id);
+    }
+  }
+  //the removed player's counter goes away
+  mapRemove(tournament->players, (MapKeyElement) &player_id);
+  tournament->players_count--;
+  return CHESS_SUCCESS;
 }
 
-ChessResult tournamentRemoveMatch(Tournament tournament, Match match);
+ChessResult tournamentRemoveMatch(Tournament tournament, Match match)
+{
+  if(tournament == NULL || match == NULL)
+  {
+    return CHESS_NULL_ARGUMENT;
+  }
+  if(matchVectorRemove(tournament->matches, match))
+  {
+    tournamentCountResult(tournament, match, false);
+    tournamentPlayerRemoveGame(tournament, matchGetFirst(match), matchGetSecond(match));
+    tournamentPlayerRemoveGame(tournament, matchGetSecond(match), matchGetFirst(match));
+  }
+  return CHESS_SUCCESS;
+}
 
 ChessResult tournamentEnd(Tournament tournament)
 {
@@ -159,44 +348,25 @@ ChessResult tournamentEnd(Tournament tournament)
   {
     return CHESS_NULL_ARGUMENT;
   }
-  Player current;
-  Player temp;
   int max_result = -1;
   int curr_result = 0;
-  matchNode games_played;
-  matchNode ptr;
-  ChessResult status;
-  //going over the players. for each player creating a matchnode list of his games and calculating result
-  MAP_FOREACH(Player,current, tournament->players)
-  {
-    tournamentGetMatchesByPlayer(tournament, current->id, games_played);
-    ptr = games_played;
-    while(ptr) //going over all games played by current
-    {
-      status = matchGetWinner(getMatchFromMatchNode(ptr),temp);
-      if(status == CHESS_SUCCESS)
-      {
-        if(playerCompare(current,temp) == 0 ) //if the winner of the match is current
-        {
-          curr_result += 2;
-        }
-        else if(temp == NULL) //there was a draw
-        {
-          curr_result == 1;
-        }
-      }
-      ptr = nextMatchNode(ptr);
-    }
+  //going over the players. each player's wins and draws are already counted
+  //the iterator borrows the players from the map, so no key is copied on the way
+  MAP_ITERATE(iterator, tournament->players)
+  {
+    int current_id = *(int *) mapIteratorKey(&iterator);
+    TournamentPlayer current = mapIteratorData(&iterator);
+    curr_result = 2 * current->wins + current->draws;
     if(curr_result > max_result) //replace winner if we got a better result
     {
       max_result = curr_result;
-      tournament->winner = current;
+      tournament->winner_id = current_id;
     }
     else if(curr_result == max_result) //if results are the same
     {
-      if(playerGetId(tournament->winner) > playerGetId(current)) //chose the one with "lower" id
+      if(tournament->winner_id > current_id) //chose the one with "lower" id
       {
-        tournament->winner = current;
+        tournament->winner_id = current_id;
       }
     }
   }
@@ -206,7 +376,55 @@ ChessResult tournamentEnd(Tournament tournament)
 
 ChessResult tournamentGetMatchesByPlayer(Tournament tournament, 
                                          int player_id, 
-                                         matchNode *list);
+                                         MatchVector *list)
+{
+  if(tournament == NULL || list == NULL)
+  {
+    return CHESS_NULL_ARGUMENT;
+  }
+  *list = NULL;
+  if(!mapContains(tournament->players, (MapKeyElement) &player_id))
+  {
+    return CHESS_PLAYER_NOT_EXIST;
+  }
+  MatchVector player_matches = matchVectorCreate(MATCH_HOOK_NONE, NULL);
+  if(player_matches == NULL)
+  {
+    return CHESS_OUT_OF_MEMORY;
+  }
+  Match *matches = matchVectorData(tournament->matches);
+  for(int i = 0; i < matchVectorGetSize(tournament->matches); i++)
+  {
+    if(playerGetId(matchGetFirst(matches[i])) == player_id || playerGetId(matchGetSecond(matches[i])) == player_id)
+    {
+      if(matchVectorPush(player_matches, matches[i]) != CHESS_SUCCESS)
+      {
+        matchVectorDestroy(player_matches, false);
+        return CHESS_OUT_OF_MEMORY;
+      }
+    }
+  }
+  *list = player_matches;
+  return CHESS_SUCCESS;
+}
+
+MatchVector tournamentGetMatches(Tournament tournament)
+{
+  if(tournament == NULL)
+  {
+    return NULL;
+  }
+  return tournament->matches;
+}
+
+MatchArena tournamentGetMatchArena(Tournament tournament)
+{
+  if(tournament == NULL)
+  {
+    return NULL;
+  }
+  return tournament->arena;
+}
 
 void tournamentDestroy(Tournament tournament)
 {
@@ -214,9 +432,11 @@ void tournamentDestroy(Tournament tournament)
   {
     return;
   }
-  matchNodeDestroy(tournament->matches, true);
-  mapDestroy(tournament->players);
-  playerDestroy(tournament->winner, false);
+  //the matches are freed with the arena, not one by one
+  matchVectorDestroy(tournament->matches, false);
+  matchArenaDestroy(tournament->arena);
+  mapDestroy(tournament->players); //the players themselves belong to the chess system
+  free(tournament->location);
   free(tournament);
 }
 
@@ -229,27 +449,34 @@ bool tournamentIsEnded(Tournament tournament)
 {
   if(tournament == NULL)
   {
-    return NULL;
+    return false;
   }
   return tournament->finished;
 }
 
-Tournament tournamentCopy(Tournament original)
+int tournamentGetWinnerId(Tournament tournament)
 {
-  if(original == NULL)
+  if(tournament == NULL)
   {
-    return NULL;
+    return 0;
   }
-  Tournament new_tournament;
-  new_tournament = tournamentCreate(original->id, original->location, original->max_matches_per_player);
-  if(new_tournament == NULL)
+  return tournament->winner_id;
+}
+
+const char *tournamentGetLocation(Tournament tournament)
+{
+  if(tournament == NULL)
   {
     return NULL;
   }
-  new_tournament->finished = original->finished;
-  new_tournament->players_count = original->players_count;
-  new_tournament->winner = original->winner;
-  new_tournament->matches = original->matches;
-  new_tournament->players = original->players;
-  return new_tournament;
+  return tournament->location;
+}
+
+int tournamentGetPlayersCount(Tournament tournament)
+{
+  if(tournament == NULL)
+  {
+    return 0;
+  }
+  return tournament->players_count;
 }
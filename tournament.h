@@ -1,12 +1,11 @@
 #ifndef _TOURNAMENT_H
 #define _TOURNAMENT_H
 
-#include "matchnode.h"
+typedef struct tournament_t *Tournament;
+
+#include "matchvector.h"
 #include "player.h"
 #include "match.h"
-#include "utils.h"
-
-typedef struct tournament_t *Tournament;
 
 /**
  * Create a new instance of Tournament
@@ -35,17 +34,21 @@ Tournament tournamentCreate(int id, const char *location, int max_games_per_play
  *     CHESS_TOURNAMENT_ENDED - the tournament is over
  *     CHESS_GAME_ALREADY_EXIST - match with the same participants was already
  *                                added to the tournament
- *     CHESS_INVALID_MAX_GAMES - one of the particiapnts has already reached the
- *                               maximum games allowed
+ *     CHESS_EXCEEDED_GAMES - one of the particiapnts has already reached the
+ *                            maximum games allowed
+ *     CHESS_OUT_OF_MEMORY - memory related failure
  *     CHESS_SUCCESS - match was added successfully.
  */
 ChessResult tournamentAddMatch(Tournament tournament, Match match);
 
 /**
  * Remove a player from a tournament. 
- * All matches the player participated in will be forfeited.
- * If player wasn't in the tournament - nothing happens and the method will
- * be considered successful.
+ * All matches the player participated in will be forfeited, and his
+ * opponents keep their games played.
+ * If the tournament has ended, its results (and winner) are kept, and only
+ * the tournament's reference to the player is dropped.
+ * If player wasn't in the tournament - nothing happens and the method will be
+ * considered successful.
  * 
  * @param tournament Tournament to remove the player from
  * @param int id of the player to be removed
@@ -56,7 +59,8 @@ ChessResult tournamentAddMatch(Tournament tournament, Match match);
 ChessResult tournamentRemovePlayer(Tournament tournament, int player_id);
 
 /**
- * Removes a match from a tournament's matches list.
+ * Removes a match from a tournament's matches list. The match is no longer
+ * counted in its players' games played.
  * If match wasn't in the tournament - nothing happens and the method will
  * be considered successful.
  * 
@@ -84,25 +88,49 @@ ChessResult tournamentRemoveMatch(Tournament tournament, Match match);
 ChessResult tournamentEnd(Tournament tournament);
 
 /**
- * Compiles a list of Matches of which the provided player was a participant.
+ * Compiles a vector of Matches of which the provided player was a participant.
  * 
  * @param tournament Tournament in question
  * @param player_id Id of player in question
- * @param list OUT pointer to a linked list of matches.
+ * @param list OUT pointer to a MatchVector of matches.
  *             NULL if return value != CHESS_SUCCESS
- *             caller's responsibility to free the list.
+ *             caller's responsibility to destroy the vector (without its
+ *             matches).
  * @return
  *    CHESS_NULL_ARGUMENT - provided argument was NULL
  *    CHESS_PLAYER_NOT_EXIST - player didn't play in the tournament
+ *    CHESS_OUT_OF_MEMORY - memory related failure
  *    CHESS_SUCCESS - list was compiled successfully.
  */
 ChessResult tournamentGetMatchesByPlayer(Tournament tournament, 
                                          int player_id, 
-                                         matchNode *list);
+                                         MatchVector *list);
+
+/**
+ * Gets the matches of the tournament.
+ * 
+ * @param tournament Tournament in question
+ * @return
+ *    NULL if NULL argument was provided
+ *    The tournament's MatchVector otherwise. The vector belongs to the
+ *    tournament and must not be changed by the caller.
+ */
+MatchVector tournamentGetMatches(Tournament tournament);
+
+/**
+ * Gets the MatchArena the tournament's matches are allocated from.
+ * 
+ * @param tournament Tournament in question
+ * @return
+ *    NULL if NULL argument was provided
+ *    The tournament's MatchArena otherwise
+ */
+MatchArena tournamentGetMatchArena(Tournament tournament);
 
 /**
  * Destroys a Tournament instance
- * Frees all private memory.
+ * Frees all private memory, including the tournament's matches (their arena
+ * is released at once).
  * 
  * @param tournament Tournament to destory
  */
@@ -130,13 +158,30 @@ int tournamentCompare(Tournament tournament1, Tournament tournament2);
 bool tournamentIsEnded(Tournament tournament);
 
 /**
- * Creates a copy of the provided Tournament for the Map object.
+ * Gets the id of the winner of an ended tournament. The winner may have been
+ * removed from the system since.
  * 
- * @param original Tournament to be copied
- * @return 
- *    New exact copy of the provided Tournament
- *    NULL if memory allocation failed
+ * @param tournament tournament in question
+ * @return id of the winner, 0 if the tournament hasn't ended, had no games or
+ *         NULL was provided
+ */
+int tournamentGetWinnerId(Tournament tournament);
+
+/**
+ * Gets the location of the tournament.
+ * 
+ * @param tournament tournament in question
+ * @return location of the tournament, NULL if NULL was provided. The string
+ *         belongs to the tournament.
+ */
+const char *tournamentGetLocation(Tournament tournament);
+
+/**
+ * Gets the number of players who played in the tournament.
+ * 
+ * @param tournament tournament in question
+ * @return number of players, 0 if NULL was provided
  */
-MapDataElement tournamentCopy(MapDataElement original);
+int tournamentGetPlayersCount(Tournament tournament);
 
 #endif // _TOURNAMENT_H
\ No newline at end of file